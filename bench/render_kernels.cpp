@@ -0,0 +1,265 @@
+// Benchmark de los bucles de render especializados por modo y por material
+// Uso: bench_kernels [--width W] [--height H] [--spp N] [--depth D] [--runs R]
+//
+// Para cada escena de ejemplo mide la mediana de R renders en cada combinacion
+// de modo (final / normales) y AOVs (con / sin), con el camino generico (un bucle
+// y un kernel de sombreado que preguntan modo y material en cada muestra, como
+// estaban antes de especializar; solo existe en este archivo) y con el de
+// Renderer, y verifica que los dos den la misma imagen. Tambien cuenta que
+// familia de material ve cada rayo primario para saber que kernel domina.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "camera/Camera.h"
+#include "renderer/Renderer.h"
+#include "scene/Presets.h"
+#include "scene/Scene.h"
+
+using namespace rt;
+
+static bool sameImage(const Framebuffer& a, const Framebuffer& b) {
+  for (int j = 0; j < a.height; ++j) {
+    for (int i = 0; i < a.width; ++i) {
+      Vec3 p = a.at(i, j), q = b.at(i, j);
+      if (p.x != q.x || p.y != q.y || p.z != q.z) return false;
+    }
+  }
+  return true;
+}
+
+// Integrador previo a los kernels por material: un solo sombreado que pregunta
+// en cada impacto si el material refleja o refracta. La iluminacion directa se
+// toma de Integrator para que solo cambie el despacho.
+class GenericIntegrator {
+ public:
+  Vec3 trace(const Scene& scene, const Ray& ray, int depth, PrimaryHit* primary, uint32_t seed) const {
+    uint32_t rng = seed;
+    return traceRec(scene, ray, depth, Vec3{1,1,1}, rng, primary);
+  }
+
+  Integrator direct;
+
+ private:
+  bool keepBranch(const Vec3& w, uint32_t& rng, double& scale) const {
+    scale = 1.0;
+    double m = std::max(w.x, std::max(w.y, w.z));
+    if (m >= direct.minContribution) return true;
+    if (!direct.russianRoulette || m <= 0.0) return false;
+    double q = m / direct.minContribution;
+    rng = hash32(rng + 0x9e3779b9u);
+    if (toUnit(rng) >= q) return false;
+    scale = 1.0 / q;
+    return true;
+  }
+
+  // rama reflejada con peso escalar w
+  Vec3 reflection(const Scene& scene, const Ray& ray, const HitRecord& rec, int depth, const Vec3& throughput,
+                  double w, uint32_t& rng) const {
+    double scale;
+    if (!keepBranch(throughput * w, rng, scale)) return Vec3{0, 0, 0};
+    Vec3 reflected = reflect(ray.direction, rec.normal);
+    Vec3 c = traceRec(scene, Ray(rec.point + rec.normal * 1e-4, reflected), depth - 1,
+                      throughput * (w * scale), rng, nullptr);
+    return w * scale * c;
+  }
+
+  Vec3 traceRec(const Scene& scene, const Ray& ray, int depth, const Vec3& throughput,
+                uint32_t& rng, PrimaryHit* primary) const {
+    if (depth <= 0) return scene.background;
+    HitRecord rec;
+    if (!scene.hit(ray, 1e-4, 1e9, rec)) return scene.background;
+    if (primary) {
+      primary->hit = true;
+      primary->rec = rec;
+    }
+    const Material& mat = *rec.material;
+    Vec3 color = mat.Ka + mat.emissive;
+    if (!mat.isRefractive()) {
+      for (const auto& light : scene.lights) color += direct.lightTerm(scene, ray, rec, light);
+      if (mat.isReflective()) color += reflection(scene, ray, rec, depth, throughput, mat.reflectivity, rng);
+      return color;
+    }
+
+    Vec3 unit_direction = normalize(ray.direction);
+    double refraction_ratio = rec.frontFace ? (1.0 / mat.ior) : mat.ior;
+    Vec3 refracted;
+    bool can_refract = refract(unit_direction, rec.normal, refraction_ratio, refracted);
+    double cosTheta = std::fmin(-dot(unit_direction, rec.normal), 1.0);
+    double kr = schlickFresnel(cosTheta, rec.frontFace ? 1.0 : mat.ior, rec.frontFace ? mat.ior : 1.0);
+    double wRefl = mat.isReflective() ? kr : 0.0;
+    if (!can_refract) {
+      double wTir = wRefl + (1.0 - kr);
+      Vec3 w = throughput * wTir;
+      double scale;
+      if (keepBranch(w, rng, scale)) {
+        Vec3 reflected = reflect(unit_direction, rec.normal);
+        Vec3 c = traceRec(scene, Ray(rec.point + rec.normal * 1e-4, reflected), depth - 1, w * scale, rng, nullptr);
+        color += wTir * scale * c;
+      }
+      return color;
+    }
+    if (wRefl > 0.0) color += reflection(scene, ray, rec, depth, throughput, wRefl, rng);
+
+    Vec3 origin = rec.point - rec.normal * 1e-4;
+    Vec3 att{1.0, 1.0, 1.0};
+    const Vec3& ab = mat.absorption;
+    if (rec.frontFace && (ab.x > 0.0 || ab.y > 0.0 || ab.z > 0.0)) {
+      double distInside = 0.0;
+      HitRecord exitRec;
+      if (scene.hit(Ray(origin, refracted), 1e-4, 1e9, exitRec)) distInside = exitRec.t;
+      att = Vec3{std::exp(-ab.x * distInside), std::exp(-ab.y * distInside), std::exp(-ab.z * distInside)};
+    }
+    Vec3 wRefr = att * mat.transmissionTint * (1.0 - kr);
+    double scale;
+    if (keepBranch(throughput * wRefr, rng, scale)) {
+      Vec3 c = traceRec(scene, Ray(origin, refracted), depth - 1, throughput * wRefr * scale, rng, nullptr);
+      color += c * wRefr * scale;
+    }
+    return color;
+  }
+};
+
+// Bucle de pixeles previo a la especializacion: modo y AOVs se preguntan en cada muestra
+static Framebuffer renderGeneric(const Renderer& renderer, const GenericIntegrator& integrator,
+                                 const Scene& scene, const Camera& camera, RenderMode mode,
+                                 AuxBuffers* aux = nullptr) {
+  const int width = renderer.width, height = renderer.height, spp = renderer.spp;
+  Framebuffer pixels(width, height, renderer.format);
+  if (aux) renderer.prepareAux(*aux);
+  for (int y = 0; y < height; ++y) {
+    const int j = height - 1 - y;
+    for (int i = 0; i < width; ++i) {
+      Vec3 color{0,0,0}, nSum{0,0,0}, aSum{0,0,0};
+      double dSum = 0.0;
+      uint32_t matId = 0;
+      int hits = 0;
+      for (int s = 0; s < spp; ++s) {
+        double su = 0.5, sv = 0.5;
+        if (spp > 1) renderer.sampler->sample2D(i, j, s, spp, su, sv);
+        Ray r = camera.getRay((i + su) / (double)width, (j + sv) / (double)height);
+        PrimaryHit first;
+        if (mode == RenderMode::Normals) {
+          first.hit = scene.hit(r, 1e-4, 1e9, first.rec);
+          if (first.hit) color += 0.5 * (first.rec.normal + Vec3{1,1,1});
+        } else {
+          uint32_t seed = hashCombine(hashCombine((uint32_t)i, (uint32_t)j), (uint32_t)s);
+          color += integrator.trace(scene, r, renderer.maxDepth, aux ? &first : nullptr, seed);
+        }
+        if (aux && first.hit) {
+          nSum += first.rec.normal;
+          aSum += first.rec.material->Kd;
+          dSum += first.rec.t;
+          if (hits++ == 0) matId = first.rec.material->id();
+        }
+      }
+      int idx = y * width + i;
+      pixels.set(idx, color / (double)spp);
+      if (aux) {
+        aux->normal.set(idx, nSum / (double)spp);
+        aux->albedo.set(idx, aSum / (double)spp);
+        aux->depth[idx] = hits ? (float)(dSum / hits) : 0.0f;
+        aux->materialId[idx] = matId;
+      }
+    }
+  }
+  return pixels;
+}
+
+struct Timings {
+  double final = 0.0;
+  double aux = 0.0;
+  double normals = 0.0;
+  Framebuffer imgFinal, imgAux, imgNormals;
+  AuxBuffers buffers;
+};
+
+template <typename F>
+static double medianMs(int runs, F&& f) {
+  std::vector<double> t;
+  for (int k = 0; k < runs; ++k) {
+    auto t0 = std::chrono::steady_clock::now();
+    f();
+    auto t1 = std::chrono::steady_clock::now();
+    t.push_back(std::chrono::duration<double, std::milli>(t1 - t0).count());
+  }
+  std::sort(t.begin(), t.end());
+  return t[t.size() / 2];
+}
+
+int main(int argc, char** argv) {
+  int width = 640;
+  int height = 360;
+  int spp = 1;
+  int maxDepth = 8;
+  int runs = 5;
+  for (int i = 1; i + 1 < argc; ++i) {
+    std::string k = argv[i];
+    if (k == "--width") width = std::stoi(argv[++i]);
+    else if (k == "--height") height = std::stoi(argv[++i]);
+    else if (k == "--spp") spp = std::stoi(argv[++i]);
+    else if (k == "--depth") maxDepth = std::stoi(argv[++i]);
+    else if (k == "--runs") runs = std::stoi(argv[++i]);
+  }
+
+  std::cout << width << "x" << height << " @ " << spp << " spp, profundidad " << maxDepth
+            << ", mediana de " << runs << "\n\n";
+  std::cout << std::left << std::setw(12) << "escena" << std::right
+            << std::setw(10) << "final gen" << std::setw(10) << "final esp"
+            << std::setw(10) << "aov gen" << std::setw(10) << "aov esp"
+            << std::setw(10) << "norm gen" << std::setw(10) << "norm esp"
+            << std::setw(10) << "ganancia" << std::setw(10) << "Mray/s"
+            << "  iguales   primarios diff/mirror/diel/trans\n";
+
+  for (const std::string name : {"base", "final", "instancias"}) {
+    Scene scene;
+    buildScene(name, scene);
+    scene.freeze();
+    Camera cam = makeCamera(name, "frontal", width, height);
+
+    Renderer renderer(width, height, spp, maxDepth);
+    GenericIntegrator generic;
+    auto measure = [&](bool specialized) {
+      auto render = [&](RenderMode mode, AuxBuffers* aux) {
+        return specialized ? renderer.render(scene, cam, mode, aux) : renderGeneric(renderer, generic, scene, cam, mode, aux);
+      };
+      Timings t;
+      t.final = medianMs(runs, [&] { t.imgFinal = render(RenderMode::Final, nullptr); });
+      t.aux = medianMs(runs, [&] { t.imgAux = render(RenderMode::Final, &t.buffers); });
+      t.normals = medianMs(runs, [&] { t.imgNormals = render(RenderMode::Normals, nullptr); });
+      return t;
+    };
+    Timings esp = measure(true);
+    Timings gen = measure(false);
+    bool same = sameImage(gen.imgFinal, esp.imgFinal) && sameImage(gen.imgAux, esp.imgAux) &&
+                sameImage(gen.imgNormals, esp.imgNormals) && sameImage(gen.buffers.normal, esp.buffers.normal) &&
+                gen.buffers.depth == esp.buffers.depth && gen.buffers.materialId == esp.buffers.materialId;
+
+    // familia de material del primer impacto, por pixel
+    size_t kinds[4] = {0, 0, 0, 0};
+    for (int j = 0; j < height; ++j) {
+      for (int i = 0; i < width; ++i) {
+        HitRecord rec;
+        Ray r = cam.getRay((i + 0.5) / width, (j + 0.5) / height);
+        if (scene.hit(r, 1e-4, 1e9, rec)) ++kinds[(int)rec.material->kind()];
+      }
+    }
+    double rays = (double)width * height * spp;
+
+    std::cout << std::left << std::setw(12) << name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(10) << gen.final << std::setw(10) << esp.final
+              << std::setw(10) << gen.aux << std::setw(10) << esp.aux
+              << std::setw(10) << gen.normals << std::setw(10) << esp.normals
+              << std::setw(9) << std::setprecision(2) << gen.final / esp.final << "x"
+              << std::setw(10) << rays / (esp.final * 1e3) << "  " << std::setw(7) << (same ? "si" : "NO") << "   "
+              << kinds[0] << "/" << kinds[1] << "/" << kinds[2] << "/" << kinds[3] << "\n";
+  }
+  std::cout << "\n(tiempos en ms por frame; ganancia = final gen / final esp; Mray/s cuenta solo rayos de\n"
+            << " camara en modo final especializado)\n";
+  return 0;
+}
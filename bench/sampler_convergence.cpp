@@ -0,0 +1,182 @@
+// Benchmark de convergencia de los samplers de AA sobre los bordes de la escena final
+// Uso: bench_samplers [--width W] [--height H] [--ref-spp N] [--trials T] [--camera vista]
+//
+// Se renderiza una referencia con muchas muestras, se detectan los pixeles de
+// borde (gradiente alto en la referencia) y para cada sampler y cada spp se
+// mide el RMSE contra la referencia solo en esos pixeles. Al final compara el
+// denoiser a 4 spp contra 64 spp sin filtrar (bordes y toda la imagen).
+
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "camera/Camera.h"
+#include "renderer/Denoiser.h"
+#include "renderer/Renderer.h"
+#include "sampling/Sampler.h"
+#include "scene/Presets.h"
+#include "scene/Scene.h"
+
+using namespace rt;
+
+static double luminance(const Vec3& c) {
+  return 0.2126 * c.x + 0.7152 * c.y + 0.0722 * c.z;
+}
+
+// pixeles cuyo contraste con algun vecino supera el umbral
+static std::vector<int> edgePixels(const Framebuffer& ref, double threshold) {
+  std::vector<int> edges;
+  const int w = ref.width, h = ref.height;
+  for (int y = 1; y < h - 1; ++y) {
+    for (int x = 1; x < w - 1; ++x) {
+      double c = luminance(ref.at(x, y));
+      double g = 0.0;
+      g = std::fmax(g, std::fabs(c - luminance(ref.at(x - 1, y))));
+      g = std::fmax(g, std::fabs(c - luminance(ref.at(x + 1, y))));
+      g = std::fmax(g, std::fabs(c - luminance(ref.at(x, y - 1))));
+      g = std::fmax(g, std::fabs(c - luminance(ref.at(x, y + 1))));
+      if (g > threshold) edges.push_back(y * w + x);
+    }
+  }
+  return edges;
+}
+
+static double rmse(const Framebuffer& img, const Framebuffer& ref, const std::vector<int>& idx) {
+  double acc = 0.0;
+  for (int k : idx) {
+    Vec3 d = clamp01(img.get(k)) - clamp01(ref.get(k));
+    acc += d.lengthSquared() / 3.0;
+  }
+  return idx.empty() ? 0.0 : std::sqrt(acc / idx.size());
+}
+
+static std::vector<int> allPixels(const Framebuffer& img) {
+  std::vector<int> idx(img.size());
+  for (size_t k = 0; k < idx.size(); ++k) idx[k] = (int)k;
+  return idx;
+}
+
+int main(int argc, char** argv) {
+  int width = 160;
+  int height = 90;
+  int refSpp = 1024;
+  int trials = 4;
+  int maxDepth = 6;
+  std::string view = "frontal";
+  for (int i = 1; i + 1 < argc; ++i) {
+    std::string k = argv[i];
+    if (k == "--width") width = std::stoi(argv[++i]);
+    else if (k == "--height") height = std::stoi(argv[++i]);
+    else if (k == "--ref-spp") refSpp = std::stoi(argv[++i]);
+    else if (k == "--trials") trials = std::stoi(argv[++i]);
+    else if (k == "--camera") view = argv[++i];
+  }
+
+  Scene scene;
+  buildFinalScene(scene);
+  scene.freeze();
+  Camera cam = makeFinalCamera(view, width, height);
+
+  Renderer renderer(width, height, refSpp, maxDepth);
+  renderer.format = PixelFormat::RGB64F;
+  renderer.sampler = std::make_shared<StratifiedSampler>();
+  auto reference = renderer.render(scene, cam, RenderMode::Final);
+  auto edges = edgePixels(reference, 0.05);
+  std::cout << "referencia: " << width << "x" << height << " @ " << refSpp
+            << " spp, pixeles de borde: " << edges.size() << "\n\n";
+
+  const std::vector<std::string> names{"random", "stratified", "halton", "sobol", "bluenoise"};
+  const std::vector<int> sppList{2, 4, 8, 16, 32, 64};
+
+  std::cout << std::left << std::setw(12) << "sampler";
+  for (int spp : sppList) std::cout << std::right << std::setw(11) << ("spp " + std::to_string(spp));
+  std::cout << std::setw(11) << "ms/frame" << "\n";
+
+  std::vector<std::vector<double>> errors;
+  for (const auto& name : names) {
+    std::cout << std::left << std::setw(12) << name << std::flush;
+    std::vector<double> row;
+    double totalMs = 0.0;
+    for (int spp : sppList) {
+      double err = 0.0;
+      for (int t = 0; t < trials; ++t) {
+        auto sampler = makeSampler(name);
+        sampler->seed = 1000u + (uint32_t)t;
+        renderer.spp = spp;
+        renderer.sampler = sampler;
+        auto t0 = std::chrono::steady_clock::now();
+        auto img = renderer.render(scene, cam, RenderMode::Final);
+        auto t1 = std::chrono::steady_clock::now();
+        totalMs += std::chrono::duration<double, std::milli>(t1 - t0).count();
+        err += rmse(img, reference, edges);
+      }
+      err /= trials;
+      row.push_back(err);
+      std::cout << std::right << std::setw(11) << std::fixed << std::setprecision(5) << err << std::flush;
+    }
+    std::cout << std::setw(11) << std::setprecision(1) << totalMs / (trials * sppList.size()) << "\n";
+    errors.push_back(row);
+  }
+
+  // spp que necesita cada sampler para igualar el error de random a 32 spp
+  std::cout << "\nspp equivalente a random@32 (interpolacion log-log):\n";
+  double target = errors[0][4];
+  for (size_t s = 0; s < names.size(); ++s) {
+    double equiv = sppList.back();
+    for (size_t k = 0; k + 1 < sppList.size(); ++k) {
+      double e0 = errors[s][k], e1 = errors[s][k + 1];
+      if (e0 >= target && e1 <= target && e0 > e1) {
+        double a = std::log(e0 / target) / std::log(e0 / e1);
+        equiv = sppList[k] * std::pow((double)sppList[k + 1] / sppList[k], a);
+        break;
+      }
+      if (k == 0 && e0 <= target) { equiv = sppList[0]; break; }
+    }
+    std::cout << "  " << std::left << std::setw(12) << names[s] << std::setprecision(1) << equiv
+              << "  (x" << std::setprecision(2) << 32.0 / equiv << " menos muestras)\n";
+  }
+
+  // 4 spp con denoiser contra 64 spp sin filtrar, mismo sampler (promedio de trials)
+  const std::vector<int> all = allPixels(reference);
+  double err4 = 0.0, err4Edges = 0.0, errD = 0.0, errDEdges = 0.0, err64 = 0.0, err64Edges = 0.0;
+  double ms4 = 0.0, msD = 0.0, ms64 = 0.0;
+  Denoiser denoiser;
+  for (int t = 0; t < trials; ++t) {
+    auto sampler = makeSampler("stratified");
+    sampler->seed = 2000u + (uint32_t)t;
+    renderer.sampler = sampler;
+    renderer.spp = 4;
+    AuxBuffers aux;
+    auto t0 = std::chrono::steady_clock::now();
+    auto img = renderer.render(scene, cam, RenderMode::Final, &aux);
+    auto t1 = std::chrono::steady_clock::now();
+    err4 += rmse(img, reference, all);
+    err4Edges += rmse(img, reference, edges);
+    denoiser.apply(img, aux);
+    auto t2 = std::chrono::steady_clock::now();
+    errD += rmse(img, reference, all);
+    errDEdges += rmse(img, reference, edges);
+    renderer.spp = 64;
+    auto img64 = renderer.render(scene, cam, RenderMode::Final);
+    auto t3 = std::chrono::steady_clock::now();
+    err64 += rmse(img64, reference, all);
+    err64Edges += rmse(img64, reference, edges);
+    ms4 += std::chrono::duration<double, std::milli>(t1 - t0).count();
+    msD += std::chrono::duration<double, std::milli>(t2 - t1).count();
+    ms64 += std::chrono::duration<double, std::milli>(t3 - t2).count();
+  }
+  std::cout << "\ndenoiser (stratified, RMSE imagen / bordes, ms):\n" << std::setprecision(5);
+  auto line = [&](const char* name, double e, double eEdges, double ms) {
+    std::cout << "  " << std::left << std::setw(22) << name << std::right << std::setw(9) << e / trials
+              << std::setw(9) << eEdges / trials << std::setw(9) << std::setprecision(1) << ms / trials << "\n"
+              << std::setprecision(5);
+  };
+  line("4 spp", err4, err4Edges, ms4);
+  line("4 spp + denoiser", errD, errDEdges, ms4 + msD);
+  line("64 spp", err64, err64Edges, ms64);
+
+  return 0;
+}
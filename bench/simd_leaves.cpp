@@ -0,0 +1,101 @@
+// Benchmark de los kernels SIMD de hojas: un rayo contra muchas esferas/triangulos
+// Uso: bench_simd [--rays N] [--seed S]
+//
+// Arma escenas con N esferas y N triangulos al azar dentro de un cubo y lanza rayos
+// incoherentes (origen y direccion al azar, como rebotes y sombras). Para cada N mide
+// consultas de impacto mas cercano y de oclusion por segundo con el camino escalar
+// y con el de la CPU, y verifica que los dos den exactamente el mismo resultado.
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "geometry/SimdKernels.h"
+#include "geometry/Sphere.h"
+#include "geometry/Triangle.h"
+#include "materials/Material.h"
+#include "scene/Scene.h"
+#include "utils/Random.h"
+
+using namespace rt;
+
+struct Rng {
+  uint32_t state;
+  double next() {
+    state = hash32(state + 0x9e3779b9u);
+    return toUnit(state);
+  }
+  double range(double lo, double hi) { return lo + (hi - lo) * next(); }
+  Vec3 inCube(double h) { return Vec3{range(-h, h), range(-h, h), range(-h, h)}; }
+};
+
+struct Result {
+  double closestMs = 0.0;
+  double occludedMs = 0.0;
+  std::vector<double> ts;
+  std::vector<char> blocked;
+};
+
+static Result run(const Scene& scene, const std::vector<Ray>& rays) {
+  Result res;
+  res.ts.reserve(rays.size());
+  res.blocked.reserve(rays.size());
+  auto t0 = std::chrono::steady_clock::now();
+  for (const Ray& r : rays) {
+    HitRecord rec;
+    res.ts.push_back(scene.hit(r, 1e-4, 1e9, rec) ? rec.t : -1.0);
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  for (const Ray& r : rays) res.blocked.push_back(scene.isOccluded(r, 1e-4, 4.0) ? 1 : 0);
+  auto t2 = std::chrono::steady_clock::now();
+  res.closestMs = std::chrono::duration<double, std::milli>(t1 - t0).count();
+  res.occludedMs = std::chrono::duration<double, std::milli>(t2 - t1).count();
+  return res;
+}
+
+int main(int argc, char** argv) {
+  int numRays = 200000;
+  uint32_t seed = 7;
+  for (int i = 1; i + 1 < argc; ++i) {
+    std::string k = argv[i];
+    if (k == "--rays") numRays = std::stoi(argv[++i]);
+    else if (k == "--seed") seed = (uint32_t)std::stoul(argv[++i]);
+  }
+
+  const SimdLevel cpu = detectSimd();
+  std::cout << "cpu: " << simdName(cpu) << ", " << numRays << " rayos incoherentes por prueba\n\n";
+  std::cout << std::setw(6) << "N" << std::setw(16) << "cercano esc" << std::setw(16) << "cercano simd"
+            << std::setw(16) << "oclusion esc" << std::setw(16) << "oclusion simd" << "  iguales\n";
+
+  auto mat = std::make_shared<Lambertian>(Vec3{0.5, 0.5, 0.5});
+  for (int n : {4, 8, 16, 64, 256}) {
+    Rng rng{seed};
+    Scene scene;
+    for (int k = 0; k < n; ++k) {
+      scene.addObject(std::make_shared<Sphere>(rng.inCube(4.0), rng.range(0.05, 0.4), mat));
+      Vec3 a = rng.inCube(4.0);
+      scene.addObject(std::make_shared<Triangle>(a, a + rng.inCube(0.6), a + rng.inCube(0.6), mat));
+    }
+    scene.freeze();
+
+    std::vector<Ray> rays;
+    rays.reserve(numRays);
+    for (int k = 0; k < numRays; ++k) rays.emplace_back(rng.inCube(4.0), normalize(rng.inCube(1.0)));
+
+    activeSimd() = SimdLevel::Scalar;
+    Result scalar = run(scene, rays);
+    activeSimd() = cpu;
+    Result simd = run(scene, rays);
+
+    bool same = scalar.ts == simd.ts && scalar.blocked == simd.blocked;
+    auto mrays = [&](double ms) { return numRays / (ms * 1e3); };
+    std::cout << std::setw(6) << n << std::fixed << std::setprecision(2)
+              << std::setw(11) << mrays(scalar.closestMs) << " Mr/s" << std::setw(11) << mrays(simd.closestMs) << " Mr/s"
+              << std::setw(11) << mrays(scalar.occludedMs) << " Mr/s" << std::setw(11) << mrays(simd.occludedMs) << " Mr/s"
+              << "  " << (same ? "si" : "NO") << "\n";
+  }
+  return 0;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "core/Vec3.h"
+
+namespace rt {
+
+// precision con la que se guarda cada pixel
+// RGB64F: 3 doubles (24 bytes), RGB32F: 3 floats (12 bytes)
+enum class PixelFormat { RGB64F, RGB32F };
+
+inline bool parsePixelFormat(const std::string& s, PixelFormat& out) {
+  if (s == "rgb64" || s == "double") { out = PixelFormat::RGB64F; return true; }
+  if (s == "rgb32" || s == "float") { out = PixelFormat::RGB32F; return true; }
+  return false;
+}
+
+// Imagen de ancho x alto en el formato elegido. Los escritores leen de aca
+// directamente, fila por fila, sin pasar por una copia en Vec3.
+class Framebuffer {
+ public:
+  Framebuffer() = default;
+  Framebuffer(int w, int h, PixelFormat f = PixelFormat::RGB32F)
+    : width(w), height(h), format(f) {
+    size_t n = (size_t)w * h * 3;
+    if (f == PixelFormat::RGB64F) d.assign(n, 0.0);
+    else f32.assign(n, 0.0f);
+  }
+
+  inline size_t size() const { return (size_t)width * height; }
+  inline size_t bytes() const { return d.size() * sizeof(double) + f32.size() * sizeof(float); }
+
+  inline void set(size_t idx, const Vec3& c) {
+    size_t o = idx * 3;
+    if (format == PixelFormat::RGB64F) {
+      d[o] = c.x; d[o + 1] = c.y; d[o + 2] = c.z;
+    } else {
+      f32[o] = (float)c.x; f32[o + 1] = (float)c.y; f32[o + 2] = (float)c.z;
+    }
+  }
+
+  inline Vec3 get(size_t idx) const {
+    size_t o = idx * 3;
+    if (format == PixelFormat::RGB64F) return Vec3{d[o], d[o + 1], d[o + 2]};
+    return Vec3{f32[o], f32[o + 1], f32[o + 2]};
+  }
+
+  inline Vec3 at(int i, int j) const { return get((size_t)j * width + i); }
+
+  int width{0};
+  int height{0};
+  PixelFormat format{PixelFormat::RGB32F};
+
+ private:
+  std::vector<double> d;
+  std::vector<float> f32;
+};
+
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cmath>
+
+#include "core/Vec3.h"
+#include "core/Ray.h"
+
+namespace rt {
+
+// Transformacion afin 3x4 que guarda tambien su inversa.
+// Se arma componiendo traslaciones, escalas y rotaciones (cada una con inversa
+// conocida), asi nunca hace falta invertir una matriz general.
+struct Transform {
+  double m[3][4] = {{1,0,0,0},{0,1,0,0},{0,0,1,0}};
+  double inv[3][4] = {{1,0,0,0},{0,1,0,0},{0,0,1,0}};
+
+  static Transform translate(const Vec3& t) {
+    Transform r;
+    r.m[0][3] = t.x;  r.m[1][3] = t.y;  r.m[2][3] = t.z;
+    r.inv[0][3] = -t.x; r.inv[1][3] = -t.y; r.inv[2][3] = -t.z;
+    return r;
+  }
+
+  static Transform scale(const Vec3& s) {
+    Transform r;
+    r.m[0][0] = s.x; r.m[1][1] = s.y; r.m[2][2] = s.z;
+    r.inv[0][0] = 1.0 / s.x; r.inv[1][1] = 1.0 / s.y; r.inv[2][2] = 1.0 / s.z;
+    return r;
+  }
+
+  static Transform scale(double s) { return scale(Vec3{s, s, s}); }
+
+  // rotacion en grados alrededor de un eje (Rodrigues); la inversa es la transpuesta
+  static Transform rotate(const Vec3& axis, double degrees) {
+    Vec3 a = normalize(axis);
+    double th = degrees * M_PI / 180.0;
+    double c = std::cos(th), s = std::sin(th), k = 1.0 - c;
+    double R[3][3] = {
+      {a.x*a.x*k + c,     a.x*a.y*k - a.z*s, a.x*a.z*k + a.y*s},
+      {a.y*a.x*k + a.z*s, a.y*a.y*k + c,     a.y*a.z*k - a.x*s},
+      {a.z*a.x*k - a.y*s, a.z*a.y*k + a.x*s, a.z*a.z*k + c}
+    };
+    Transform r;
+    for (int i = 0; i < 3; ++i) {
+      for (int j = 0; j < 3; ++j) {
+        r.m[i][j] = R[i][j];
+        r.inv[i][j] = R[j][i];
+      }
+    }
+    return r;
+  }
+
+  // composicion: (a * b)(p) = a(b(p))
+  Transform operator*(const Transform& b) const {
+    Transform r;
+    mul(m, b.m, r.m);
+    mul(b.inv, inv, r.inv);
+    return r;
+  }
+
+  inline Vec3 point(const Vec3& p) const { return apply(m, p, 1.0); }
+  inline Vec3 vector(const Vec3& v) const { return apply(m, v, 0.0); }
+  inline Vec3 invPoint(const Vec3& p) const { return apply(inv, p, 1.0); }
+  inline Vec3 invVector(const Vec3& v) const { return apply(inv, v, 0.0); }
+
+  // normales: transpuesta de la inversa (sin normalizar)
+  inline Vec3 normal(const Vec3& n) const {
+    return Vec3{
+      inv[0][0]*n.x + inv[1][0]*n.y + inv[2][0]*n.z,
+      inv[0][1]*n.x + inv[1][1]*n.y + inv[2][1]*n.z,
+      inv[0][2]*n.x + inv[1][2]*n.y + inv[2][2]*n.z
+    };
+  }
+
+  // rayo de mundo a espacio objeto; la direccion no se normaliza para que t
+  // sea el mismo parametro en los dos espacios
+  inline Ray toLocal(const Ray& r) const { return Ray(invPoint(r.origin), invVector(r.direction)); }
+
+ private:
+  static Vec3 apply(const double a[3][4], const Vec3& p, double w) {
+    return Vec3{
+      a[0][0]*p.x + a[0][1]*p.y + a[0][2]*p.z + a[0][3]*w,
+      a[1][0]*p.x + a[1][1]*p.y + a[1][2]*p.z + a[1][3]*w,
+      a[2][0]*p.x + a[2][1]*p.y + a[2][2]*p.z + a[2][3]*w
+    };
+  }
+
+  static void mul(const double a[3][4], const double b[3][4], double out[3][4]) {
+    for (int i = 0; i < 3; ++i) {
+      for (int j = 0; j < 4; ++j) {
+        double v = a[i][0]*b[0][j] + a[i][1]*b[1][j] + a[i][2]*b[2][j];
+        if (j == 3) v += a[i][3];
+        out[i][j] = v;
+      }
+    }
+  }
+};
+
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <algorithm>
+#include <limits>
+
+#include "core/Vec3.h"
+#include "core/Ray.h"
+
+namespace rt {
+
+// caja alineada a los ejes; vacia por defecto (min > max)
+struct AABB {
+  Vec3 min{ std::numeric_limits<double>::infinity(),  std::numeric_limits<double>::infinity(),  std::numeric_limits<double>::infinity()};
+  Vec3 max{-std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity()};
+
+  AABB() = default;
+  AABB(const Vec3& a, const Vec3& b)
+    : min{std::min(a.x, b.x), std::min(a.y, b.y), std::min(a.z, b.z)},
+      max{std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z)} {}
+
+  inline bool empty() const { return min.x > max.x || min.y > max.y || min.z > max.z; }
+
+  inline void expand(const Vec3& p) {
+    min = Vec3{std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z)};
+    max = Vec3{std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z)};
+  }
+
+  inline void expand(const AABB& b) {
+    if (b.empty()) return;
+    expand(b.min);
+    expand(b.max);
+  }
+
+  // agranda un poco las caras planas para que el test de slabs no las pierda
+  inline AABB padded(double eps = 1e-6) const {
+    AABB b = *this;
+    b.min -= Vec3{eps, eps, eps};
+    b.max += Vec3{eps, eps, eps};
+    return b;
+  }
+
+  inline Vec3 center() const { return (min + max) * 0.5; }
+
+  inline bool overlaps(const AABB& b) const {
+    return min.x <= b.max.x && max.x >= b.min.x
+        && min.y <= b.max.y && max.y >= b.min.y
+        && min.z <= b.max.z && max.z >= b.min.z;
+  }
+
+  // test de slabs; ajusta el intervalo [tMin, tMax] de entrada
+  inline bool hit(const Ray& r, double tMin, double tMax) const {
+    double tEnter;
+    return hit(r, tMin, tMax, tEnter);
+  }
+
+  // igual, y tEnter queda con el t de entrada a la caja (tMin si el origen esta adentro)
+  inline bool hit(const Ray& r, double tMin, double tMax, double& tEnter) const {
+    const double o[3] = {r.origin.x, r.origin.y, r.origin.z};
+    const double d[3] = {r.direction.x, r.direction.y, r.direction.z};
+    const double lo[3] = {min.x, min.y, min.z};
+    const double hi[3] = {max.x, max.y, max.z};
+    for (int a = 0; a < 3; ++a) {
+      double invD = 1.0 / d[a];
+      double t0 = (lo[a] - o[a]) * invD;
+      double t1 = (hi[a] - o[a]) * invD;
+      if (invD < 0.0) std::swap(t0, t1);
+      tMin = t0 > tMin ? t0 : tMin;
+      tMax = t1 < tMax ? t1 : tMax;
+      if (tMax < tMin) return false;
+    }
+    tEnter = tMin;
+    return true;
+  }
+};
+
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <memory>
+
+#include "geometry/Hittable.h"
+#include "materials/Material.h"
+
+namespace rt {
+
+// caja solida alineada a los ejes; se intersecta con slabs y la normal sale
+// del eje que limita la entrada (o la salida si el rayo empieza adentro)
+struct BoxData {
+  Vec3 min;
+  Vec3 max;
+  const Material* mat{nullptr};
+
+  inline bool hit(const Ray& r, double tMin, double tMax, HitRecord& rec) const {
+    const double o[3] = {r.origin.x, r.origin.y, r.origin.z};
+    const double d[3] = {r.direction.x, r.direction.y, r.direction.z};
+    const double lo[3] = {min.x, min.y, min.z};
+    const double hi[3] = {max.x, max.y, max.z};
+    double tNear = -1e300, tFar = 1e300;
+    int axisNear = 0, axisFar = 0;
+    double signNear = -1.0, signFar = 1.0;
+    for (int a = 0; a < 3; ++a) {
+      double invD = 1.0 / d[a];
+      double t0 = (lo[a] - o[a]) * invD;
+      double t1 = (hi[a] - o[a]) * invD;
+      // yendo en -eje se entra por la cara max (normal +) y se sale por la min
+      double s = invD < 0.0 ? 1.0 : -1.0;
+      if (invD < 0.0) std::swap(t0, t1);
+      if (t0 > tNear) { tNear = t0; axisNear = a; signNear = s; }
+      if (t1 < tFar) { tFar = t1; axisFar = a; signFar = -s; }
+      if (tFar < tNear) return false;
+    }
+
+    double t = tNear;
+    int axis = axisNear;
+    double sign = signNear;
+    if (t < tMin || t > tMax) {
+      t = tFar;
+      axis = axisFar;
+      sign = signFar;
+      if (t < tMin || t > tMax) return false;
+    }
+
+    rec.t = t;
+    rec.point = r.at(t);
+    // normal hacia afuera de la cara tocada
+    Vec3 outward{0,0,0};
+    if (axis == 0) outward.x = sign;
+    else if (axis == 1) outward.y = sign;
+    else outward.z = sign;
+    rec.setFaceNormal(r, outward);
+    rec.material = mat;
+    return true;
+  }
+
+  inline AABB bounds() const { return AABB(min, max).padded(); }
+
+  // geometria y material, para las claves de la cache de tiles
+  inline void hashInto(ContentHash& h) const {
+    h.addBits(5);
+    h.add(min);
+    h.add(max);
+    hashMaterial(h, mat);
+  }
+};
+
+class Box : public Hittable {
+ public:
+  Box() = default;
+  // dos esquinas opuestas cualesquiera
+  Box(const Vec3& a, const Vec3& b, std::shared_ptr<Material> m)
+    : mat(std::move(m)) {
+    AABB box(a, b);
+    data.min = box.min;
+    data.max = box.max;
+    data.mat = mat.get();
+  }
+
+  bool hit(const Ray& r, double tMin, double tMax, HitRecord& rec) const override {
+    return data.hit(r, tMin, tMax, rec);
+  }
+
+  bool boundingBox(AABB& box) const override {
+    box = data.bounds();
+    return true;
+  }
+
+  uint64_t contentHash() const override {
+    ContentHash h;
+    data.hashInto(h);
+    return h.value();
+  }
+
+  const BoxData& shape() const { return data; }
+
+ private:
+  BoxData data;
+  std::shared_ptr<Material> mat;
+};
+
+}
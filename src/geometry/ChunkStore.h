@@ -0,0 +1,682 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "geometry/AABB.h"
+#include "geometry/Box.h"
+#include "geometry/Hittable.h"
+#include "geometry/Quad.h"
+#include "geometry/Sphere.h"
+#include "geometry/Triangle.h"
+#include "materials/Material.h"
+
+namespace rt {
+
+// metricas del paginado de geometria
+struct ChunkStats {
+  size_t chunks{0};            // chunks en disco
+  size_t pageIns{0};           // lecturas de un chunk no residente
+  size_t evictions{0};         // chunks desalojados para respetar el presupuesto
+  size_t bytesRead{0};
+  size_t residentBytes{0};
+  size_t peakResidentBytes{0};
+  double ioMillis{0.0};        // tiempo leyendo y armando chunks
+  size_t readErrors{0};        // chunks que no se pudieron leer (el frame no es valido)
+};
+
+// Primitivas acotadas de una PrimitiveArena (esferas, triangulos, quads, cajas)
+// repartidas en chunks espacialmente coherentes dentro de un archivo (lo arma un
+// ChunkWriter). En memoria quedan solo la tabla de chunks (caja, desplazamiento,
+// tamanio), los materiales y los chunks que se usaron hace poco, hasta budgetBytes;
+// el resto se lee del disco cuando un rayo entra en su caja y se desaloja el menos
+// usado (LRU).
+//
+// Las cajas de los chunks forman un BVH chico que queda residente (sale de la misma
+// particion que arma los chunks). hit lo recorre de adelante hacia atras y descarta
+// todo nodo cuya entrada quede detras del impacto encontrado. Cada primitiva guarda su
+// posicion en el orden de la arena, y los empates en t se resuelven con ese orden
+// igual que el bucle en memoria: el frame es el mismo con o sin paginado.
+class ChunkStore {
+ public:
+  // Tamanio de chunk para un presupuesto: que entren unos 16 chunks a la vez, con
+  // hasta 256 primitivas (~25 KB de triangulos). Chunks mas grandes amortizan mejor
+  // cada lectura pero dentro de un chunk el recorrido es lineal, y las cajas de
+  // chunks chicos descartan mas primitivas por rayo.
+  static size_t primsPerChunkFor(size_t budgetBytes) {
+    size_t perChunk = budgetBytes / 16 / sizeof(TriangleData);
+    return std::max<size_t>(1, std::min<size_t>(256, perChunk));
+  }
+
+  ChunkStore(const ChunkStore&) = delete;
+  ChunkStore& operator=(const ChunkStore&) = delete;
+
+  ~ChunkStore() {
+    std::error_code ec;
+    std::filesystem::remove(file, ec);
+  }
+
+  size_t primitiveCount() const { return total; }
+
+  // Impacto mas cercano en (tMin, closest]; closest y rec quedan con el mejor impacto.
+  // Si iguala a closest gana la primitiva de la arena que venga despues, como en memoria
+  // (los planos van antes que todo lo de aca).
+  bool hit(const Ray& r, double tMin, double& closest, HitRecord& rec) const {
+    bool hitAnything = false;
+    bool bestHere = false;
+    uint64_t bestOrder = 0;
+    HitRecord temp;
+    auto visit = [&](const auto& prims, const std::vector<uint64_t>& orders) {
+      for (size_t k = 0; k < prims.size(); ++k) {
+        if (!prims[k].hit(r, tMin, closest, temp)) continue;
+        if (temp.t < closest || !bestHere || orders[k] > bestOrder) {
+          hitAnything = true;
+          bestHere = true;
+          bestOrder = orders[k];
+          closest = temp.t;
+          rec = temp;
+        }
+      }
+    };
+    walk(r, tMin, closest, [&](uint32_t k) {
+      std::shared_ptr<const Chunk> c = acquire(k);
+      visit(c->spheres, c->sphereOrder);
+      visit(c->triangles, c->triangleOrder);
+      visit(c->quads, c->quadOrder);
+      visit(c->boxes, c->boxOrder);
+      return true;
+    });
+    return hitAnything;
+  }
+
+  // test de oclusion: alcanza cualquier primitiva que proyecte sombra en (tMin, tMax)
+  bool isOccluded(const Ray& r, double tMin, double tMax) const {
+    HitRecord temp;
+    auto blocks = [&](const auto& prims) {
+      for (const auto& p : prims) {
+        if (p.hit(r, tMin, tMax, temp) && temp.material && temp.material->castsShadow) return true;
+      }
+      return false;
+    };
+    bool occluded = false;
+    walk(r, tMin, tMax, [&](uint32_t k) {
+      std::shared_ptr<const Chunk> c = acquire(k);
+      occluded = blocks(c->spheres) || blocks(c->triangles) || blocks(c->quads) || blocks(c->boxes);
+      return !occluded;
+    });
+    return occluded;
+  }
+
+  // Llama f(caja, hash) por cada chunk sin leerlo: los dos se calculan al escribir.
+  // El hash cubre cada primitiva con su posicion en el orden de la arena (de la que
+  // dependen los empates), asi que cambia si cambia cualquiera de ellas.
+  template <typename F>
+  void forEachChunk(F&& f) const {
+    for (const ChunkInfo& info : table) f(&info.box, info.hash);
+  }
+
+  // caja de todas las primitivas (union de las cajas de los chunks)
+  AABB bounds() const { return nodes.empty() ? AABB() : nodes[root].box; }
+
+  // bytes fijos en memoria: tabla de chunks, su estado, el BVH y los materiales
+  size_t tableBytes() const {
+    return table.capacity() * (sizeof(ChunkInfo) + sizeof(Slot)) + nodes.capacity() * sizeof(Node)
+         + materials.capacity() * sizeof(Material);
+  }
+
+  ChunkStats stats() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    ChunkStats s = counters;
+    s.chunks = table.size();
+    s.residentBytes = resident;
+    return s;
+  }
+
+ private:
+  friend class ChunkWriter;
+
+  ChunkStore(std::string path, size_t budgetBytes) : file(std::move(path)), budget(budgetBytes) {}
+
+  struct Chunk {
+    std::vector<SphereData> spheres;
+    std::vector<TriangleData> triangles;
+    std::vector<QuadData> quads;
+    std::vector<BoxData> boxes;
+    std::vector<uint64_t> sphereOrder, triangleOrder, quadOrder, boxOrder;
+  };
+
+  struct ChunkInfo {
+    uint64_t offset{0};
+    size_t bytes{0};
+    AABB box;
+    uint64_t hash{0}; // contenido, ver forEachChunk
+  };
+
+  // nodo del BVH de chunks: hoja si chunk != kInner
+  static constexpr uint32_t kInner = UINT32_MAX;
+  struct Node {
+    AABB box;
+    uint32_t left{0}, right{0};
+    uint32_t chunk{kInner};
+  };
+
+  // Loading: un hilo lo esta leyendo sin el lock; los demas esperan en loaded
+  enum class SlotState : uint8_t { Absent, Loading, Resident };
+  static constexpr uint32_t kNone = UINT32_MAX;
+  struct Slot {
+    std::shared_ptr<const Chunk> data; // nulo = no residente; se lee con atomic_load
+    std::atomic<uint64_t> lastUse{0};  // se marca sin lock en cada uso
+    // lo que sigue lo protege mtx
+    SlotState state{SlotState::Absent};
+    uint64_t listedAt{0};              // lastUse cuando quedo al frente de la lista
+    uint32_t prev{kNone}, next{kNone}; // lista LRU de residentes, del mas nuevo al mas viejo
+  };
+
+  // Recorre el BVH de adelante hacia atras y llama visit(chunk) en cada hoja que
+  // cruza el rayo; visit devuelve false para cortar. tMax es una referencia porque
+  // hit lo acorta con cada impacto y los nodos que quedan detras se descartan.
+  template <typename Visit>
+  void walk(const Ray& r, double tMin, const double& tMax, Visit&& visit) const {
+    if (nodes.empty()) return;
+    static thread_local std::vector<std::pair<double, uint32_t>> stack;
+    const size_t base = stack.size();
+    double t0, t1;
+    if (nodes[root].box.hit(r, tMin, tMax, t0)) stack.emplace_back(t0, root);
+    while (stack.size() > base) {
+      auto [tEnter, n] = stack.back();
+      stack.pop_back();
+      if (tEnter > tMax) continue;
+      const Node& node = nodes[n];
+      if (node.chunk != kInner) {
+        if (!visit(node.chunk)) {
+          stack.resize(base);
+          return;
+        }
+        continue;
+      }
+      bool hitLeft = nodes[node.left].box.hit(r, tMin, tMax, t0);
+      bool hitRight = nodes[node.right].box.hit(r, tMin, tMax, t1);
+      // el mas cercano queda arriba de la pila
+      if (hitLeft && hitRight && t1 < t0) {
+        stack.emplace_back(t0, node.left);
+        stack.emplace_back(t1, node.right);
+      } else {
+        if (hitRight) stack.emplace_back(t1, node.right);
+        if (hitLeft) stack.emplace_back(t0, node.left);
+      }
+    }
+  }
+
+  // Formato de un chunk: por tipo (esferas, triangulos, quads, cajas) la cantidad y
+  // las primitivas byte a byte, con el material como indice + 1 en materials
+  // (0 = sin material); despues los ordenes de cada tipo, sin cantidad.
+  template <typename T>
+  bool takeArray(const std::string& buf, size_t& pos, std::vector<T>& v) const {
+    uint64_t n;
+    if (pos + sizeof n > buf.size()) return false;
+    std::memcpy(&n, buf.data() + pos, sizeof n);
+    pos += sizeof n;
+    if (n > (buf.size() - pos) / sizeof(T)) return false;
+    v.resize((size_t)n);
+    for (auto& p : v) {
+      std::memcpy(&p, buf.data() + pos, sizeof p);
+      pos += sizeof p;
+      uintptr_t idx = reinterpret_cast<uintptr_t>(p.mat);
+      p.mat = idx ? materials.data() + (idx - 1) : nullptr;
+    }
+    return true;
+  }
+
+  static bool takeOrders(const std::string& buf, size_t& pos, size_t n, std::vector<uint64_t>& v) {
+    if (n > (buf.size() - pos) / sizeof(uint64_t)) return false;
+    v.resize(n);
+    std::memcpy(v.data(), buf.data() + pos, n * sizeof(uint64_t));
+    pos += n * sizeof(uint64_t);
+    return true;
+  }
+
+  // se llama sin el lock: cada lectura abre su propio stream
+  std::shared_ptr<const Chunk> read(uint32_t k, bool& good) const {
+    const ChunkInfo& info = table[k];
+    std::string buf(info.bytes, '\0');
+    std::ifstream in(file, std::ios::binary);
+    in.seekg((std::streamoff)info.offset);
+    auto c = std::make_shared<Chunk>();
+    size_t pos = 0;
+    good = in.read(&buf[0], (std::streamsize)buf.size()) &&
+                takeArray(buf, pos, c->spheres) && takeArray(buf, pos, c->triangles) &&
+                takeArray(buf, pos, c->quads) && takeArray(buf, pos, c->boxes) &&
+                takeOrders(buf, pos, c->spheres.size(), c->sphereOrder) &&
+                takeOrders(buf, pos, c->triangles.size(), c->triangleOrder) &&
+                takeOrders(buf, pos, c->quads.size(), c->quadOrder) &&
+                takeOrders(buf, pos, c->boxes.size(), c->boxOrder);
+    // un chunk ilegible queda vacio y se cuenta: el frame sale distinto y el llamador
+    // tiene que mirar stats().readErrors
+    if (!good) return std::make_shared<Chunk>();
+    return c;
+  }
+
+  // Chunk k residente. Un acierto solo marca lastUse, sin lock. Un fallo marca el
+  // slot como Loading y lee del disco fuera del lock, asi los demas hilos siguen
+  // con sus chunks; los que piden el mismo esperan a que termine esa lectura.
+  std::shared_ptr<const Chunk> acquire(uint32_t k) const {
+    Slot& slot = slots[k];
+    slot.lastUse.store(++clock, std::memory_order_relaxed);
+    std::shared_ptr<const Chunk> c = std::atomic_load(&slot.data);
+    if (c) return c;
+
+    std::unique_lock<std::mutex> lock(mtx);
+    for (;;) {
+      c = std::atomic_load(&slot.data); // otro hilo pudo leerlo mientras esperabamos
+      if (c) return c;
+      if (slot.state != SlotState::Loading) break;
+      loaded.wait(lock);
+    }
+    slot.state = SlotState::Loading;
+    lock.unlock();
+    auto t0 = std::chrono::steady_clock::now();
+    bool good = false;
+    c = read(k, good);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    lock.lock();
+
+    counters.ioMillis += ms;
+    ++counters.pageIns;
+    counters.bytesRead += table[k].bytes;
+    if (!good) ++counters.readErrors;
+    std::atomic_store(&slot.data, c);
+    slot.state = SlotState::Resident;
+    slot.listedAt = slot.lastUse.load(std::memory_order_relaxed);
+    pushFront(k);
+    resident += table[k].bytes;
+    evict(k);
+    counters.peakResidentBytes = std::max(counters.peakResidentBytes, resident);
+    lock.unlock();
+    loaded.notify_all();
+    return c;
+  }
+
+  // Desaloja desde la cola de la lista hasta volver al presupuesto. Como los aciertos
+  // no toman el lock, la cola se reordena aca: un chunk usado despues de quedar al
+  // frente vuelve al frente en vez de salir (a lo sumo una vez por chunk en cada
+  // llamada). Siempre queda al menos el chunk recien leido, aunque sea mas grande que
+  // el presupuesto; los rayos que todavia usan un chunk desalojado lo mantienen vivo.
+  void evict(uint32_t keep) const {
+    size_t promoted = 0;
+    while (resident > budget && listed > 1) {
+      uint32_t v = tail;
+      Slot& s = slots[v];
+      uint64_t used = s.lastUse.load(std::memory_order_relaxed);
+      unlink(v);
+      if (v == keep) {
+        pushFront(v);
+        continue;
+      }
+      if (used > s.listedAt && promoted++ < listed) {
+        s.listedAt = used;
+        pushFront(v);
+        continue;
+      }
+      std::atomic_store(&s.data, std::shared_ptr<const Chunk>());
+      s.state = SlotState::Absent;
+      resident -= table[v].bytes;
+      ++counters.evictions;
+    }
+  }
+
+  void pushFront(uint32_t k) const {
+    Slot& s = slots[k];
+    s.prev = kNone;
+    s.next = head;
+    if (head != kNone) slots[head].prev = k;
+    head = k;
+    if (tail == kNone) tail = k;
+    ++listed;
+  }
+
+  void unlink(uint32_t k) const {
+    Slot& s = slots[k];
+    if (s.prev != kNone) slots[s.prev].next = s.next;
+    else head = s.next;
+    if (s.next != kNone) slots[s.next].prev = s.prev;
+    else tail = s.prev;
+    s.prev = s.next = kNone;
+    --listed;
+  }
+
+  std::string file;
+  size_t budget;
+  size_t total{0};
+  std::vector<Material> materials; // los punteros de los chunks leidos apuntan aca
+  std::vector<ChunkInfo> table;
+  std::vector<Node> nodes;
+  uint32_t root{0};
+  std::unique_ptr<Slot[]> slots;
+
+  mutable std::mutex mtx; // protege el estado de los slots, la lista, resident y counters
+  mutable std::condition_variable loaded;
+  mutable std::atomic<uint64_t> clock{0};
+  mutable uint32_t head{kNone}, tail{kNone};
+  mutable size_t listed{0};
+  mutable size_t resident{0};
+  mutable ChunkStats counters;
+};
+
+// Arma un ChunkStore a medida que llegan las primitivas, sin tenerlas todas en
+// memoria. add copia cada una a un archivo de paso como registro de tamanio fijo.
+// finish parte ese archivo por el eje mas largo de los centroides (cerca de la
+// mediana, con un histograma) en archivos mas chicos hasta que cada parte entra en
+// memoria, y cada parte se reparte en chunks por la mediana. Cada pasada lee y
+// escribe en secuencia: en memoria hay a lo sumo una parte, la tabla y el BVH. Las
+// particiones en disco son los nodos de arriba del BVH.
+class ChunkWriter {
+ public:
+  ChunkWriter(std::string path, size_t budgetBytes)
+    : file(std::move(path)), budget(budgetBytes), perChunk(ChunkStore::primsPerChunkFor(budgetBytes)) {
+    std::string first = newPart();
+    spill.open(first, std::ios::binary | std::ios::trunc);
+    ok = (bool)spill;
+  }
+
+  ChunkWriter(const ChunkWriter&) = delete;
+  ChunkWriter& operator=(const ChunkWriter&) = delete;
+
+  ~ChunkWriter() {
+    spill.close();
+    std::error_code ec;
+    for (const auto& part : parts) std::filesystem::remove(part, ec);
+  }
+
+  // false si no se pudo crear el archivo de paso
+  bool good() const { return ok; }
+
+  // cada tipo se numera en orden de llegada, igual que los arreglos de PrimitiveArena::freeze
+  void add(const SphereData& p) { put(1, spheres++, p); }
+  void add(const TriangleData& p) { put(2, triangles++, p); }
+  void add(const QuadData& p) { put(3, quads++, p); }
+  void add(const BoxData& p) { put(4, boxes++, p); }
+
+  size_t count() const { return total; }
+
+  // Escribe los chunks en path; nulo si fallo alguna lectura o escritura. El store
+  // se queda con los materiales y borra el archivo al destruirse.
+  std::unique_ptr<ChunkStore> finish() {
+    spill.close();
+    ok = ok && !spill.fail();
+    std::unique_ptr<ChunkStore> store(new ChunkStore(file, budget));
+    store->materials = std::move(materials);
+    std::ofstream out(file, std::ios::binary | std::ios::trunc);
+    ok = ok && (bool)out;
+    if (ok && total > 0) store->root = partition(*store, out, parts.front(), total, centroids);
+    out.close();
+    if (!ok || out.fail()) return nullptr;
+    store->total = total;
+    store->slots.reset(new ChunkStore::Slot[store->table.size()]);
+    return store;
+  }
+
+ private:
+  static constexpr size_t kDataBytes = std::max({sizeof(SphereData), sizeof(TriangleData), sizeof(QuadData), sizeof(BoxData)});
+  static constexpr size_t kBins = 1024;      // histograma para elegir el corte de una particion en disco
+  static constexpr size_t kMinBucket = 4096; // registros: menos no vale una pasada por disco
+
+  struct Record {
+    uint64_t order; // (tipo << 48) | indice del tipo
+    unsigned char data[kDataBytes]; // la primitiva con el material como indice + 1
+  };
+
+  struct Item {
+    uint64_t order;
+    size_t rec; // posicion en la parte leida
+    Vec3 centroid;
+    AABB box;
+  };
+
+  static size_t dataBytes(uint64_t rank) {
+    const size_t sizes[5] = {0, sizeof(SphereData), sizeof(TriangleData), sizeof(QuadData), sizeof(BoxData)};
+    return sizes[rank];
+  }
+
+  // f(primitiva) con el tipo del registro; con mats nulo el material queda como indice
+  template <typename F>
+  static void visitRecord(const Record& r, const Material* mats, F&& f) {
+    auto load = [&](auto p) {
+      std::memcpy(&p, r.data, sizeof p);
+      if (mats) {
+        uintptr_t idx = reinterpret_cast<uintptr_t>(p.mat);
+        p.mat = idx ? mats + (idx - 1) : nullptr;
+      }
+      f(p);
+    };
+    switch (r.order >> 48) {
+      case 1: load(SphereData{}); break;
+      case 2: load(TriangleData{}); break;
+      case 3: load(QuadData{}); break;
+      default: load(BoxData{}); break;
+    }
+  }
+
+  static AABB boundsOf(const Record& r) {
+    AABB b;
+    visitRecord(r, nullptr, [&](const auto& p) { b = p.bounds(); });
+    return b;
+  }
+
+  std::string newPart() {
+    parts.push_back(file + ".parte" + std::to_string(parts.size()));
+    return parts.back();
+  }
+
+  // los materiales se copian una vez por contenido: el dueno puede liberarlos
+  // despues de agregar la primitiva y otro puede caer en la misma direccion
+  uintptr_t materialIndex(const Material* m) {
+    if (!m) return 0;
+    ContentHash h;
+    m->hashInto(h);
+    auto it = matIndex.find(h.value());
+    if (it != matIndex.end()) return it->second + 1;
+    materials.push_back(*m);
+    matIndex.emplace(h.value(), materials.size() - 1);
+    return materials.size();
+  }
+
+  template <typename T>
+  void put(uint64_t rank, uint64_t index, T p) {
+    static_assert(std::is_trivially_copyable<T>::value, "las primitivas se copian byte a byte");
+    Record r{};
+    r.order = (rank << 48) | index;
+    centroids.expand(p.bounds().center());
+    p.mat = reinterpret_cast<const Material*>(materialIndex(p.mat));
+    std::memcpy(r.data, &p, sizeof p);
+    spill.write(reinterpret_cast<const char*>(&r), sizeof r);
+    ++total;
+  }
+
+  // registros por parte en memoria: con su Item, la mitad del presupuesto
+  size_t bucketRecords() const {
+    return std::max({2 * perChunk, kMinBucket, budget / 2 / (sizeof(Record) + sizeof(Item))});
+  }
+
+  // lee los n registros de part en orden; false (y ok = false) si faltan
+  template <typename F>
+  bool eachRecord(const std::string& part, size_t n, F&& f) {
+    std::ifstream in(part, std::ios::binary);
+    Record r;
+    size_t got = 0;
+    while (got < n && in.read(reinterpret_cast<char*>(&r), sizeof r)) {
+      f(r);
+      ++got;
+    }
+    ok = ok && got == n;
+    return got == n;
+  }
+
+  // nodo del BVH que cubre los n registros de part; part se borra al terminar
+  uint32_t partition(ChunkStore& store, std::ofstream& out, std::string part, size_t n, const AABB& cbox) {
+    std::error_code ec;
+    if (n <= bucketRecords()) {
+      std::vector<Record> recs;
+      recs.reserve(n);
+      bool read = eachRecord(part, n, [&](const Record& r) { recs.push_back(r); });
+      std::filesystem::remove(part, ec);
+      if (!read) return leafless(store);
+      std::vector<Item> items(n);
+      for (size_t k = 0; k < n; ++k) {
+        AABB b = boundsOf(recs[k]);
+        items[k] = Item{recs[k].order, k, b.center(), b};
+      }
+      return split(store, out, recs, items, 0, n);
+    }
+
+    Vec3 ext = cbox.max - cbox.min;
+    int axis = ext.x >= ext.y && ext.x >= ext.z ? 0 : (ext.y >= ext.z ? 1 : 2);
+    double lo = axis == 0 ? cbox.min.x : axis == 1 ? cbox.min.y : cbox.min.z;
+    double width = axis == 0 ? ext.x : axis == 1 ? ext.y : ext.z;
+    auto bin = [&](const Record& r) {
+      Vec3 c = boundsOf(r).center();
+      double key = axis == 0 ? c.x : axis == 1 ? c.y : c.z;
+      double f = width > 0.0 ? (key - lo) / width : 0.0;
+      return std::min(kBins - 1, (size_t)std::max(0.0, f * kBins));
+    };
+    // corte en el borde de bin mas cerca de la mitad; si todo cae en un bin se parte
+    // por posicion en el archivo
+    std::vector<size_t> hist(kBins, 0);
+    if (!eachRecord(part, n, [&](const Record& r) { ++hist[bin(r)]; })) return leafless(store);
+    size_t cut = 0, below = 0, best = n;
+    for (size_t b = 1, acc = hist[0]; b < kBins; acc += hist[b], ++b) {
+      size_t gap = acc > n / 2 ? acc - n / 2 : n / 2 - acc;
+      if (acc > 0 && acc < n && gap < best) {
+        best = gap;
+        cut = b;
+        below = acc;
+      }
+    }
+    bool byPosition = cut == 0;
+    if (byPosition) below = n / 2;
+
+    std::string leftPart = newPart(), rightPart = newPart();
+    std::ofstream left(leftPart, std::ios::binary | std::ios::trunc), right(rightPart, std::ios::binary | std::ios::trunc);
+    AABB leftBox, rightBox;
+    size_t seen = 0;
+    eachRecord(part, n, [&](const Record& r) {
+      bool toLeft = byPosition ? seen++ < below : bin(r) < cut;
+      (toLeft ? left : right).write(reinterpret_cast<const char*>(&r), sizeof r);
+      (toLeft ? leftBox : rightBox).expand(boundsOf(r).center());
+    });
+    left.close();
+    right.close();
+    ok = ok && !left.fail() && !right.fail();
+    std::filesystem::remove(part, ec);
+    if (!ok) return leafless(store);
+
+    ChunkStore::Node inner;
+    inner.left = partition(store, out, leftPart, below, leftBox);
+    inner.right = partition(store, out, rightPart, n - below, rightBox);
+    return addInner(store, inner);
+  }
+
+  // nodo de relleno cuando algo fallo; finish igual devuelve nulo
+  static uint32_t leafless(ChunkStore& store) {
+    store.nodes.push_back(ChunkStore::Node{});
+    return (uint32_t)store.nodes.size() - 1;
+  }
+
+  static uint32_t addInner(ChunkStore& store, ChunkStore::Node inner) {
+    inner.box = store.nodes[inner.left].box;
+    inner.box.expand(store.nodes[inner.right].box);
+    store.nodes.push_back(inner);
+    return (uint32_t)store.nodes.size() - 1;
+  }
+
+  // parte por la mediana del eje mas largo de los centroides hasta que cada grupo
+  // entra en un chunk; devuelve el nodo del BVH que cubre [begin, end)
+  uint32_t split(ChunkStore& store, std::ofstream& out, const std::vector<Record>& recs, std::vector<Item>& items,
+                 size_t begin, size_t end) {
+    if (end - begin <= perChunk) {
+      std::vector<Item> group(items.begin() + begin, items.begin() + end);
+      ChunkStore::Node leaf;
+      leaf.chunk = emit(store, out, recs, group);
+      leaf.box = store.table[leaf.chunk].box;
+      store.nodes.push_back(leaf);
+      return (uint32_t)store.nodes.size() - 1;
+    }
+    AABB c;
+    for (size_t k = begin; k < end; ++k) c.expand(items[k].centroid);
+    Vec3 ext = c.max - c.min;
+    int axis = ext.x >= ext.y && ext.x >= ext.z ? 0 : (ext.y >= ext.z ? 1 : 2);
+    auto key = [axis](const Item& it) { return axis == 0 ? it.centroid.x : axis == 1 ? it.centroid.y : it.centroid.z; };
+    size_t mid = begin + (end - begin) / 2;
+    // desempate por orden: la particion no depende de la implementacion de nth_element
+    std::nth_element(items.begin() + begin, items.begin() + mid, items.begin() + end, [&](const Item& a, const Item& b) {
+      double ka = key(a), kb = key(b);
+      return ka < kb || (ka == kb && a.order < b.order);
+    });
+    ChunkStore::Node inner;
+    inner.left = split(store, out, recs, items, begin, mid);
+    inner.right = split(store, out, recs, items, mid, end);
+    return addInner(store, inner);
+  }
+
+  // escribe el grupo como un chunk (formato en ChunkStore::takeArray) y devuelve su indice
+  uint32_t emit(ChunkStore& store, std::ofstream& out, const std::vector<Record>& recs, std::vector<Item>& group) {
+    // dentro del chunk, en el orden de la arena
+    std::sort(group.begin(), group.end(), [](const Item& a, const Item& b) { return a.order < b.order; });
+    std::string buf;
+    for (uint64_t rank = 1; rank <= 4; ++rank) {
+      uint64_t n = 0;
+      for (const Item& it : group) n += it.order >> 48 == rank;
+      buf.append(reinterpret_cast<const char*>(&n), sizeof n);
+      for (const Item& it : group) {
+        if (it.order >> 48 == rank) buf.append(reinterpret_cast<const char*>(recs[it.rec].data), dataBytes(rank));
+      }
+    }
+    for (uint64_t rank = 1; rank <= 4; ++rank) {
+      for (const Item& it : group) {
+        if (it.order >> 48 == rank) buf.append(reinterpret_cast<const char*>(&it.order), sizeof it.order);
+      }
+    }
+    ChunkStore::ChunkInfo info;
+    info.offset = (uint64_t)out.tellp();
+    info.bytes = buf.size();
+    ContentHash h;
+    for (const Item& it : group) {
+      h.addBits(it.order);
+      visitRecord(recs[it.rec], store.materials.data(), [&](const auto& p) { p.hashInto(h); });
+    }
+    info.hash = h.value();
+    for (const Item& it : group) info.box.expand(it.box);
+    // margen para que un impacto en el borde nunca quede antes de la entrada a la caja
+    info.box = info.box.padded();
+    out.write(buf.data(), (std::streamsize)buf.size());
+    store.table.push_back(info);
+    return (uint32_t)store.table.size() - 1;
+  }
+
+  std::string file;
+  size_t budget;
+  size_t perChunk;
+  bool ok{false};
+  std::vector<std::string> parts; // archivos de paso; parts[0] recibe lo que llega por add
+  std::ofstream spill;
+  size_t total{0};
+  uint64_t spheres{0}, triangles{0}, quads{0}, boxes{0};
+  AABB centroids;
+  std::vector<Material> materials;
+  std::unordered_map<uint64_t, size_t> matIndex; // hash de contenido -> materials
+};
+
+}
@@ -1,9 +1,11 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
 
 #include "core/Vec3.h"
 #include "core/Ray.h"
+#include "geometry/AABB.h"
 
 namespace rt {
 
@@ -14,7 +16,7 @@ struct HitRecord {
   Vec3 normal;
   double t = 0.0;
   bool frontFace = true;
-  std::shared_ptr<Material> material;
+  const Material* material = nullptr; // lo mantiene vivo la escena
 
   inline void setFaceNormal(const Ray& r, const Vec3& outwardNormal) {
     frontFace = dot(r.direction, outwardNormal) < 0.0;
@@ -26,6 +28,11 @@ class Hittable {
  public:
   virtual ~Hittable() = default;
   virtual bool hit(const Ray& r, double tMin, double tMax, HitRecord& rec) const = 0;
+  // caja envolvente; false si el objeto no es acotado (ej. plano infinito)
+  virtual bool boundingBox(AABB& box) const { (void)box; return false; }
+  // hash de todo lo que afecta al sombreado (forma, transformacion, materiales);
+  // 0 = desconocido, y la cache de tiles no reutiliza regiones que lleguen al objeto
+  virtual uint64_t contentHash() const { return 0; }
 };
 
 }
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <memory>
+
+#include "core/Transform.h"
+#include "geometry/AABB.h"
+#include "geometry/Hittable.h"
+#include "geometry/PrimitiveArena.h"
+
+namespace rt {
+
+// Geometria compartida en espacio objeto (ej. una silla). Se arma una sola vez,
+// se congela a su propia arena compacta y la referencian muchas Instance.
+class GeometryGroup : public Hittable {
+ public:
+  void add(const std::shared_ptr<Hittable>& obj) { prims.add(obj); }
+
+  // compila la arena y calcula la caja; llamar antes de instanciar
+  void freeze() {
+    prims.freeze();
+    isBounded = prims.bounds(box);
+    hash = prims.contentHash();
+  }
+
+  bool hit(const Ray& r, double tMin, double tMax, HitRecord& rec) const override {
+    if (isBounded && !box.hit(r, tMin, tMax)) return false;
+    return prims.hit(r, tMin, tMax, rec);
+  }
+
+  bool boundingBox(AABB& out) const override {
+    out = box;
+    return isBounded;
+  }
+
+  uint64_t contentHash() const override { return hash; }
+
+  size_t primitiveCount() const { return prims.primitiveCount(); }
+
+ private:
+  PrimitiveArena prims;
+  AABB box;
+  bool isBounded{false};
+  uint64_t hash{0};
+};
+
+// Copia de un GeometryGroup ubicada con una transformacion propia y, opcionalmente,
+// otro material. El rayo se lleva a espacio objeto al intersectar, asi la memoria
+// crece con la geometria unica mas una matriz por instancia.
+class Instance : public Hittable {
+ public:
+  Instance(std::shared_ptr<const GeometryGroup> g, const Transform& toWorld,
+           std::shared_ptr<Material> materialOverride = nullptr)
+    : group(std::move(g)), xf(toWorld), overrideMat(std::move(materialOverride)) {
+    AABB local;
+    isBounded = group->boundingBox(local);
+    if (isBounded) {
+      // caja de mundo: las 8 esquinas transformadas
+      for (int k = 0; k < 8; ++k) {
+        Vec3 c{(k & 1) ? local.max.x : local.min.x,
+               (k & 2) ? local.max.y : local.min.y,
+               (k & 4) ? local.max.z : local.min.z};
+        worldBox.expand(xf.point(c));
+      }
+    }
+    if (uint64_t g = group->contentHash()) {
+      ContentHash h;
+      h.addBits(6);
+      h.addBits(g);
+      for (int r = 0; r < 3; ++r) {
+        for (int c = 0; c < 4; ++c) h.add(xf.m[r][c]);
+      }
+      hashMaterial(h, overrideMat.get());
+      hash = h.value();
+    }
+  }
+
+  bool hit(const Ray& r, double tMin, double tMax, HitRecord& rec) const override {
+    if (isBounded && !worldBox.hit(r, tMin, tMax)) return false;
+    // t es el mismo en los dos espacios porque la direccion local no se normaliza
+    if (!group->hit(xf.toLocal(r), tMin, tMax, rec)) return false;
+    rec.point = r.at(rec.t);
+    // la transpuesta inversa conserva el signo de dot(d, n): la normal sigue de frente al rayo
+    rec.normal = normalize(xf.normal(rec.normal));
+    if (overrideMat) rec.material = overrideMat.get();
+    return true;
+  }
+
+  bool boundingBox(AABB& out) const override {
+    out = worldBox;
+    return isBounded;
+  }
+
+  uint64_t contentHash() const override { return hash; }
+
+ private:
+  std::shared_ptr<const GeometryGroup> group;
+  Transform xf;
+  std::shared_ptr<Material> overrideMat;
+  AABB worldBox;
+  bool isBounded{false};
+  uint64_t hash{0};
+};
+
+}
@@ -3,17 +3,17 @@
 #include <memory>
 
 #include "geometry/Hittable.h"
+#include "materials/Material.h"
 
 namespace rt {
 
 // plano infinito definido por normal unitaria n y valor d tal que n·p + d = 0
-class Plane : public Hittable {
- public:
-  Plane() = default;
-  Plane(const Vec3& n, double d, std::shared_ptr<Material> m)
-    : normalUnit(normalize(n)), dval(d), mat(std::move(m)) {}
+struct PlaneData {
+  Vec3 normalUnit{0,1,0};
+  double dval{0};
+  const Material* mat{nullptr};
 
-  bool hit(const Ray& r, double tMin, double tMax, HitRecord& rec) const override {
+  inline bool hit(const Ray& r, double tMin, double tMax, HitRecord& rec) const {
     double denom = dot(normalUnit, r.direction);
     if (std::fabs(denom) < 1e-9) return false; // paralelo
     double t = -(dot(normalUnit, r.origin) + dval) / denom;
@@ -25,12 +25,36 @@ class Plane : public Hittable {
     return true;
   }
 
+  // geometria y material, para las claves de la cache de tiles
+  inline void hashInto(ContentHash& h) const {
+    h.addBits(3);
+    h.add(normalUnit);
+    h.add(dval);
+    hashMaterial(h, mat);
+  }
+};
+
+class Plane : public Hittable {
+ public:
+  Plane() = default;
+  Plane(const Vec3& n, double d, std::shared_ptr<Material> m)
+    : data{normalize(n), d, m.get()}, mat(std::move(m)) {}
+
+  bool hit(const Ray& r, double tMin, double tMax, HitRecord& rec) const override {
+    return data.hit(r, tMin, tMax, rec);
+  }
+
+  uint64_t contentHash() const override {
+    ContentHash h;
+    data.hashInto(h);
+    return h.value();
+  }
+
+  const PlaneData& shape() const { return data; }
+
  private:
-  Vec3 normalUnit{0,1,0};
-  double dval{0};
+  PlaneData data;
   std::shared_ptr<Material> mat;
 };
 
 }
-
-
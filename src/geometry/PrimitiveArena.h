@@ -0,0 +1,268 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+
+#include "geometry/Hittable.h"
+#include "geometry/AABB.h"
+#include "geometry/Sphere.h"
+#include "geometry/Triangle.h"
+#include "geometry/Plane.h"
+#include "geometry/Quad.h"
+#include "geometry/Box.h"
+#include "geometry/ChunkStore.h"
+#include "geometry/SimdKernels.h"
+#include "materials/Material.h"
+
+namespace rt {
+
+// Conjunto de primitivas con su copia compacta (ver freeze). Lo usan la escena
+// y los grupos de geometria compartidos por instancias.
+class PrimitiveArena {
+ public:
+  PrimitiveArena() = default;
+  // las primitivas congeladas apuntan a materialArena: no se copia ni se mueve
+  PrimitiveArena(const PrimitiveArena&) = delete;
+  PrimitiveArena& operator=(const PrimitiveArena&) = delete;
+
+  // fuera de memoria (ver streamTo) esferas, triangulos, quads y cajas se copian al
+  // escritor de chunks y no se guardan
+  void add(const std::shared_ptr<Hittable>& obj) {
+    if (writer) {
+      if (auto* s = dynamic_cast<const Sphere*>(obj.get())) return writer->add(s->shape());
+      if (auto* t = dynamic_cast<const Triangle*>(obj.get())) return writer->add(t->shape());
+      if (auto* q = dynamic_cast<const Quad*>(obj.get())) return writer->add(q->shape());
+      if (auto* b = dynamic_cast<const Box*>(obj.get())) return writer->add(b->shape());
+    }
+    objects.push_back(obj);
+  }
+
+  // Modo fuera de memoria, antes de agregar primitivas: las acotadas (esferas,
+  // triangulos, quads, cajas) van a un ChunkWriter a medida que llegan y freeze arma
+  // con ellas chunks espaciales en path (ver ChunkStore), que se leen a demanda con a
+  // lo sumo budgetBytes en memoria. Planos, objetos y sus materiales quedan
+  // residentes. false si ya hay primitivas o no se pudo crear el archivo de paso;
+  // si falla la escritura de los chunks, despues de freeze chunks() queda nulo.
+  bool streamTo(const std::string& path, size_t budgetBytes) {
+    if (isFrozen || writer || !objects.empty()) return false;
+    auto w = std::make_unique<ChunkWriter>(path, budgetBytes);
+    if (!w->good()) return false;
+    writer = std::move(w);
+    return true;
+  }
+
+  // Compila a arreglos contiguos por tipo (materiales, planos, esferas,
+  // triangulos, quads, cajas) en orden de insercion y libera el grafo de shared_ptr de la
+  // construccion. Las primitivas que no se conocen quedan en objects.
+  // Despues de congelar el conjunto es de solo lectura.
+  void freeze() {
+    if (isFrozen) return;
+    if (writer) {
+      store = writer->finish();
+      writer.reset();
+    }
+    // primero los materiales, para que las direcciones de la arena no cambien despues
+    std::unordered_map<const Material*, size_t> matIndex;
+    std::vector<const Material*> order;
+    auto collect = [&](const Material* m) {
+      if (m && matIndex.emplace(m, order.size()).second) order.push_back(m);
+    };
+    for (const auto& obj : objects) {
+      if (auto* p = dynamic_cast<const Plane*>(obj.get())) collect(p->shape().mat);
+      else if (auto* s = dynamic_cast<const Sphere*>(obj.get())) collect(s->shape().mat);
+      else if (auto* t = dynamic_cast<const Triangle*>(obj.get())) collect(t->shape().mat);
+      else if (auto* q = dynamic_cast<const Quad*>(obj.get())) collect(q->shape().mat);
+      else if (auto* b = dynamic_cast<const Box*>(obj.get())) collect(b->shape().mat);
+    }
+    materialArena.reserve(order.size());
+    for (const Material* m : order) materialArena.push_back(*m);
+    auto remap = [&](const Material* m) -> const Material* {
+      return m ? &materialArena[matIndex.at(m)] : nullptr;
+    };
+
+    std::vector<std::shared_ptr<Hittable>> rest;
+    for (const auto& obj : objects) {
+      if (auto* p = dynamic_cast<const Plane*>(obj.get())) {
+        planes.push_back(p->shape());
+        planes.back().mat = remap(planes.back().mat);
+      } else if (auto* s = dynamic_cast<const Sphere*>(obj.get())) {
+        spheres.push_back(s->shape());
+        spheres.back().mat = remap(spheres.back().mat);
+      } else if (auto* t = dynamic_cast<const Triangle*>(obj.get())) {
+        triangles.push_back(t->shape());
+        triangles.back().mat = remap(triangles.back().mat);
+      } else if (auto* q = dynamic_cast<const Quad*>(obj.get())) {
+        quads.push_back(q->shape());
+        quads.back().mat = remap(quads.back().mat);
+      } else if (auto* b = dynamic_cast<const Box*>(obj.get())) {
+        boxes.push_back(b->shape());
+        boxes.back().mat = remap(boxes.back().mat);
+      } else {
+        rest.push_back(obj);
+      }
+    }
+    planes.shrink_to_fit();
+    spheres.shrink_to_fit();
+    triangles.shrink_to_fit();
+    quads.shrink_to_fit();
+    boxes.shrink_to_fit();
+    // copia en bloques de 4 para los kernels SIMD (ver SimdKernels.h)
+    sphereLanes = packSpheres(spheres);
+    triangleLanes = packTriangles(triangles);
+    objects.swap(rest);
+    isFrozen = true;
+  }
+
+  bool frozen() const { return isFrozen; }
+
+  // chunks en disco, o nulo si la geometria esta toda en memoria
+  const ChunkStore* chunks() const { return store.get(); }
+
+  // bytes de la copia compacta (sin contar las primitivas que quedaron en objects);
+  // fuera de memoria cuenta la tabla de chunks pero no los chunks residentes
+  size_t frozenBytes() const {
+    return (store ? store->tableBytes() : 0)
+         + materialArena.capacity() * sizeof(Material) + planes.capacity() * sizeof(PlaneData)
+         + spheres.capacity() * sizeof(SphereData) + triangles.capacity() * sizeof(TriangleData)
+         + quads.capacity() * sizeof(QuadData) + boxes.capacity() * sizeof(BoxData)
+         + sphereLanes.capacity() * sizeof(SphereLanes) + triangleLanes.capacity() * sizeof(TriangleLanes);
+  }
+
+  size_t primitiveCount() const {
+    return planes.size() + spheres.size() + triangles.size() + quads.size() + boxes.size() + objects.size()
+         + (store ? store->primitiveCount() : 0);
+  }
+
+  bool hit(const Ray& r, double tMin, double tMax, HitRecord& rec) const {
+    HitRecord temp;
+    bool hitAnything = false;
+    double closest = tMax;
+    auto visit = [&](const auto& prim) {
+      if (prim.hit(r, tMin, closest, temp)) {
+        hitAnything = true;
+        closest = temp.t;
+        rec = temp;
+      }
+    };
+    for (const auto& p : planes) visit(p);
+    if (store) {
+      // los chunks van entre los planos y los objetos, igual que sus arreglos
+      if (store->hit(r, tMin, closest, rec)) hitAnything = true;
+    } else
+#ifdef RT_SIMD_X86
+    if (activeSimd() == SimdLevel::AVX2) {
+      // el kernel elige la primitiva; la rutina escalar rehace ese impacto y llena rec
+      double t = closest;
+      long k = avx2::closestSphere(sphereLanes, r, tMin, t);
+      if (k >= 0) visit(spheres[k]);
+      t = closest;
+      k = avx2::closestTriangle(triangleLanes, r, tMin, t);
+      if (k >= 0) visit(triangles[k]);
+    } else
+#endif
+    {
+      for (const auto& s : spheres) visit(s);
+      for (const auto& t : triangles) visit(t);
+    }
+    for (const auto& q : quads) visit(q);
+    for (const auto& b : boxes) visit(b);
+    for (const auto& obj : objects) visit(*obj);
+    return hitAnything;
+  }
+
+  // test de oclusion para rayos de sombra: ignora objetos que no proyectan sombra
+  bool isOccluded(const Ray& r, double tMin, double tMax) const {
+    HitRecord temp;
+    auto blocks = [&](const auto& prim) {
+      return prim.hit(r, tMin, tMax, temp) && temp.material && temp.material->castsShadow;
+    };
+    for (const auto& p : planes) if (blocks(p)) return true;
+    if (store) {
+      if (store->isOccluded(r, tMin, tMax)) return true;
+    } else
+#ifdef RT_SIMD_X86
+    if (activeSimd() == SimdLevel::AVX2) {
+      if (avx2::anySphere(sphereLanes, r, tMin, tMax)) return true;
+      if (avx2::anyTriangle(triangleLanes, r, tMin, tMax)) return true;
+    } else
+#endif
+    {
+      for (const auto& s : spheres) if (blocks(s)) return true;
+      for (const auto& t : triangles) if (blocks(t)) return true;
+    }
+    for (const auto& q : quads) if (blocks(q)) return true;
+    for (const auto& b : boxes) if (blocks(b)) return true;
+    for (const auto& obj : objects) if (blocks(*obj)) return true;
+    return false;
+  }
+
+  // Llama f(caja, hash) por cada primitiva, en orden fijo; caja es nullptr si no es
+  // acotada y hash es 0 si no se conoce su contenido (ver Hittable::contentHash).
+  // Lo que esta en disco va por chunk (ver ChunkStore::forEachChunk), sin leerlo.
+  template <typename F>
+  void forEachPrimitive(F&& f) const {
+    auto frozenPrim = [&](const auto& prim, const AABB* box) {
+      ContentHash h;
+      prim.hashInto(h);
+      f(box, h.value());
+    };
+    for (const auto& p : planes) frozenPrim(p, nullptr);
+    if (store) store->forEachChunk(f);
+    for (const auto& s : spheres) { AABB b = s.bounds(); frozenPrim(s, &b); }
+    for (const auto& t : triangles) { AABB b = t.bounds(); frozenPrim(t, &b); }
+    for (const auto& q : quads) { AABB b = q.bounds(); frozenPrim(q, &b); }
+    for (const auto& b : boxes) { AABB bb = b.bounds(); frozenPrim(b, &bb); }
+    for (const auto& obj : objects) {
+      AABB ob;
+      bool bounded = obj->boundingBox(ob);
+      f(bounded ? &ob : nullptr, obj->contentHash());
+    }
+  }
+
+  // hash de todo el conjunto; 0 si alguna primitiva no tiene hash
+  uint64_t contentHash() const {
+    ContentHash h;
+    bool known = true;
+    forEachPrimitive([&](const AABB*, uint64_t ph) {
+      known = known && ph != 0;
+      h.addBits(ph);
+    });
+    return known ? h.value() : 0;
+  }
+
+  // caja de todo el conjunto; false si hay algo no acotado (planos u objetos sin caja)
+  bool bounds(AABB& box) const {
+    box = AABB();
+    bool bounded = planes.empty();
+    if (store) box.expand(store->bounds());
+    for (const auto& s : spheres) box.expand(s.bounds());
+    for (const auto& t : triangles) box.expand(t.bounds());
+    for (const auto& q : quads) box.expand(q.bounds());
+    for (const auto& b : boxes) box.expand(b.bounds());
+    for (const auto& obj : objects) {
+      AABB ob;
+      if (obj->boundingBox(ob)) box.expand(ob);
+      else bounded = false;
+    }
+    return bounded && !box.empty();
+  }
+
+  std::vector<std::shared_ptr<Hittable>> objects;
+
+ private:
+  bool isFrozen{false};
+  std::vector<Material> materialArena;
+  std::vector<PlaneData> planes;
+  std::vector<SphereData> spheres;
+  std::vector<TriangleData> triangles;
+  std::vector<QuadData> quads;
+  std::vector<BoxData> boxes;
+  std::vector<SphereLanes> sphereLanes;
+  std::vector<TriangleLanes> triangleLanes;
+  std::unique_ptr<ChunkWriter> writer; // hasta freeze, ver streamTo
+  std::unique_ptr<ChunkStore> store;
+};
+
+}
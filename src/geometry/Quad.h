@@ -0,0 +1,96 @@
+#pragma once
+
+#include <memory>
+
+#include "geometry/Hittable.h"
+#include "materials/Material.h"
+
+namespace rt {
+
+// paralelogramo Q + a*u + b*v con a,b en [0,1]: un solo test plano + coordenadas
+// en lugar de dos Moller Trumbore sobre un par de triangulos
+struct QuadData {
+  Vec3 Q;
+  Vec3 u;
+  Vec3 v;
+  Vec3 w;          // n / |n|^2 con n = u x v, para sacar (a,b) con dos productos mixtos
+  Vec3 normalUnit;
+  double dval{0};  // normalUnit · Q
+  const Material* mat{nullptr};
+
+  inline bool hit(const Ray& r, double tMin, double tMax, HitRecord& rec) const {
+    double denom = dot(normalUnit, r.direction);
+    if (std::fabs(denom) < 1e-9) return false; // paralelo
+    double t = (dval - dot(normalUnit, r.origin)) / denom;
+    if (t < tMin || t > tMax) return false;
+
+    Vec3 p = r.at(t);
+    Vec3 hp = p - Q;
+    double a = dot(w, cross(hp, v));
+    if (a < 0.0 || a > 1.0) return false;
+    double b = dot(w, cross(u, hp));
+    if (b < 0.0 || b > 1.0) return false;
+
+    rec.t = t;
+    rec.point = p;
+    rec.setFaceNormal(r, normalUnit);
+    rec.material = mat;
+    return true;
+  }
+
+  inline AABB bounds() const {
+    AABB box(Q, Q + u + v);
+    box.expand(Q + u);
+    box.expand(Q + v);
+    return box.padded();
+  }
+
+  // geometria y material, para las claves de la cache de tiles
+  inline void hashInto(ContentHash& h) const {
+    h.addBits(4);
+    h.add(Q);
+    h.add(u);
+    h.add(v);
+    hashMaterial(h, mat);
+  }
+};
+
+class Quad : public Hittable {
+ public:
+  Quad() = default;
+  // esquina Q y los dos lados u, v; la normal sigue u x v como en Triangle(Q, Q+u, Q+v)
+  Quad(const Vec3& Q, const Vec3& u, const Vec3& v, std::shared_ptr<Material> m)
+    : mat(std::move(m)) {
+    Vec3 n = cross(u, v);
+    data.Q = Q;
+    data.u = u;
+    data.v = v;
+    data.w = n / dot(n, n);
+    data.normalUnit = normalize(n);
+    data.dval = dot(data.normalUnit, Q);
+    data.mat = mat.get();
+  }
+
+  bool hit(const Ray& r, double tMin, double tMax, HitRecord& rec) const override {
+    return data.hit(r, tMin, tMax, rec);
+  }
+
+  bool boundingBox(AABB& box) const override {
+    box = data.bounds();
+    return true;
+  }
+
+  uint64_t contentHash() const override {
+    ContentHash h;
+    data.hashInto(h);
+    return h.value();
+  }
+
+  const QuadData& shape() const { return data; }
+
+ private:
+  QuadData data;
+  std::shared_ptr<Material> mat;
+};
+
+}
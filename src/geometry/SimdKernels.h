@@ -0,0 +1,240 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "core/Ray.h"
+#include "geometry/Sphere.h"
+#include "geometry/Triangle.h"
+#include "materials/Material.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define RT_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+namespace rt {
+
+// Un rayo contra 4 esferas o 4 triangulos a la vez (AVX2, 4 doubles por registro).
+// Las primitivas se copian en bloques de 4 con cada coordenada contigua (SoA por bloque).
+// Los kernels hacen exactamente las mismas operaciones que SphereData::hit y
+// TriangleData::hit, en el mismo orden y sin FMA, asi el t de cada carril es el mismo
+// bit a bit; solo devuelven que primitiva gano y el HitRecord lo arma la rutina escalar.
+// Las comparaciones usan los predicados "no menor"/"no mayor" para que un NaN se
+// trate igual que en el codigo escalar.
+//
+// El binario se compila para x86-64 base: el camino AVX2 se elige en tiempo de
+// ejecucion (__builtin_cpu_supports) y si no esta disponible se usa el bucle escalar.
+
+enum class SimdLevel { Scalar, AVX2 };
+
+inline SimdLevel detectSimd() {
+#ifdef RT_SIMD_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) return SimdLevel::AVX2;
+#endif
+  return SimdLevel::Scalar;
+}
+
+// nivel en uso por todo el proceso; se puede bajar a Scalar (--simd off)
+inline SimdLevel& activeSimd() {
+  static SimdLevel level = detectSimd();
+  return level;
+}
+
+inline const char* simdName(SimdLevel level) { return level == SimdLevel::AVX2 ? "avx2" : "escalar"; }
+
+// mascaras por carril: todos los bits en 1 = verdadero
+struct alignas(32) SphereLanes {
+  double cx[4], cy[4], cz[4];
+  double rr[4]; // radio al cuadrado
+  uint64_t valid[4];
+  uint64_t shadow[4];
+};
+
+struct alignas(32) TriangleLanes {
+  double v0x[4], v0y[4], v0z[4];
+  double e1x[4], e1y[4], e1z[4];
+  double e2x[4], e2y[4], e2z[4];
+  uint64_t valid[4];
+  uint64_t shadow[4];
+};
+
+inline uint64_t laneMask(bool b) { return b ? ~0ull : 0ull; }
+inline bool castsShadow(const Material* m) { return m && m->castsShadow; }
+
+inline std::vector<SphereLanes> packSpheres(const std::vector<SphereData>& prims) {
+  std::vector<SphereLanes> out((prims.size() + 3) / 4);
+  std::memset(out.data(), 0, out.size() * sizeof(SphereLanes));
+  for (size_t k = 0; k < prims.size(); ++k) {
+    SphereLanes& b = out[k / 4];
+    size_t l = k % 4;
+    const SphereData& s = prims[k];
+    b.cx[l] = s.center.x; b.cy[l] = s.center.y; b.cz[l] = s.center.z;
+    b.rr[l] = s.radius * s.radius;
+    b.valid[l] = laneMask(true);
+    b.shadow[l] = laneMask(castsShadow(s.mat));
+  }
+  return out;
+}
+
+inline std::vector<TriangleLanes> packTriangles(const std::vector<TriangleData>& prims) {
+  std::vector<TriangleLanes> out((prims.size() + 3) / 4);
+  std::memset(out.data(), 0, out.size() * sizeof(TriangleLanes));
+  for (size_t k = 0; k < prims.size(); ++k) {
+    TriangleLanes& b = out[k / 4];
+    size_t l = k % 4;
+    const TriangleData& t = prims[k];
+    b.v0x[l] = t.v0.x; b.v0y[l] = t.v0.y; b.v0z[l] = t.v0.z;
+    b.e1x[l] = t.edge1.x; b.e1y[l] = t.edge1.y; b.e1z[l] = t.edge1.z;
+    b.e2x[l] = t.edge2.x; b.e2y[l] = t.edge2.y; b.e2z[l] = t.edge2.z;
+    b.valid[l] = laneMask(true);
+    b.shadow[l] = laneMask(castsShadow(t.mat));
+  }
+  return out;
+}
+
+#ifdef RT_SIMD_X86
+
+namespace avx2 {
+
+#define RT_AVX2 __attribute__((target("avx2")))
+
+RT_AVX2 inline __m256d mask(const uint64_t* m) {
+  return _mm256_castsi256_pd(_mm256_load_si256((const __m256i*)m));
+}
+
+// t candidato por carril (raiz cercana si cae en [tMin, tMax], si no la lejana) y mascara de impacto
+RT_AVX2 inline __m256d sphereLanes(const SphereLanes& b, const Ray& r, __m256d a, __m256d tMin, __m256d tMax,
+                                   __m256d& t) {
+  const __m256d sign = _mm256_set1_pd(-0.0);
+  __m256d ocx = _mm256_sub_pd(_mm256_set1_pd(r.origin.x), _mm256_load_pd(b.cx));
+  __m256d ocy = _mm256_sub_pd(_mm256_set1_pd(r.origin.y), _mm256_load_pd(b.cy));
+  __m256d ocz = _mm256_sub_pd(_mm256_set1_pd(r.origin.z), _mm256_load_pd(b.cz));
+  __m256d dx = _mm256_set1_pd(r.direction.x);
+  __m256d dy = _mm256_set1_pd(r.direction.y);
+  __m256d dz = _mm256_set1_pd(r.direction.z);
+  __m256d halfB = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(ocx, dx), _mm256_mul_pd(ocy, dy)), _mm256_mul_pd(ocz, dz));
+  __m256d len2 = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(ocx, ocx), _mm256_mul_pd(ocy, ocy)), _mm256_mul_pd(ocz, ocz));
+  __m256d c = _mm256_sub_pd(len2, _mm256_load_pd(b.rr));
+  __m256d disc = _mm256_sub_pd(_mm256_mul_pd(halfB, halfB), _mm256_mul_pd(a, c));
+  __m256d ok = _mm256_and_pd(mask(b.valid), _mm256_cmp_pd(disc, _mm256_setzero_pd(), _CMP_NLT_UQ));
+  __m256d sq = _mm256_sqrt_pd(disc);
+  __m256d negB = _mm256_xor_pd(halfB, sign);
+  __m256d r0 = _mm256_div_pd(_mm256_sub_pd(negB, sq), a);
+  __m256d r1 = _mm256_div_pd(_mm256_add_pd(negB, sq), a);
+  __m256d ok0 = _mm256_and_pd(_mm256_cmp_pd(r0, tMin, _CMP_NLT_UQ), _mm256_cmp_pd(r0, tMax, _CMP_NGT_UQ));
+  __m256d ok1 = _mm256_and_pd(_mm256_cmp_pd(r1, tMin, _CMP_NLT_UQ), _mm256_cmp_pd(r1, tMax, _CMP_NGT_UQ));
+  t = _mm256_blendv_pd(r1, r0, ok0);
+  return _mm256_and_pd(ok, _mm256_or_pd(ok0, ok1));
+}
+
+RT_AVX2 inline __m256d triangleLanes(const TriangleLanes& b, const Ray& r, __m256d tMin, __m256d tMax, __m256d& t) {
+  const __m256d absMask = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7fffffffffffffffll));
+  const __m256d zero = _mm256_setzero_pd();
+  const __m256d one = _mm256_set1_pd(1.0);
+  __m256d dx = _mm256_set1_pd(r.direction.x);
+  __m256d dy = _mm256_set1_pd(r.direction.y);
+  __m256d dz = _mm256_set1_pd(r.direction.z);
+  __m256d e1x = _mm256_load_pd(b.e1x), e1y = _mm256_load_pd(b.e1y), e1z = _mm256_load_pd(b.e1z);
+  __m256d e2x = _mm256_load_pd(b.e2x), e2y = _mm256_load_pd(b.e2y), e2z = _mm256_load_pd(b.e2z);
+
+  // pvec = cross(d, edge2)
+  __m256d px = _mm256_sub_pd(_mm256_mul_pd(dy, e2z), _mm256_mul_pd(dz, e2y));
+  __m256d py = _mm256_sub_pd(_mm256_mul_pd(dz, e2x), _mm256_mul_pd(dx, e2z));
+  __m256d pz = _mm256_sub_pd(_mm256_mul_pd(dx, e2y), _mm256_mul_pd(dy, e2x));
+  __m256d det = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(e1x, px), _mm256_mul_pd(e1y, py)), _mm256_mul_pd(e1z, pz));
+  __m256d ok = _mm256_and_pd(mask(b.valid),
+                             _mm256_cmp_pd(_mm256_and_pd(det, absMask), _mm256_set1_pd(1e-9), _CMP_NLT_UQ));
+  __m256d invDet = _mm256_div_pd(one, det);
+
+  // tvec = origen - v0
+  __m256d tx = _mm256_sub_pd(_mm256_set1_pd(r.origin.x), _mm256_load_pd(b.v0x));
+  __m256d ty = _mm256_sub_pd(_mm256_set1_pd(r.origin.y), _mm256_load_pd(b.v0y));
+  __m256d tz = _mm256_sub_pd(_mm256_set1_pd(r.origin.z), _mm256_load_pd(b.v0z));
+  __m256d u = _mm256_mul_pd(
+      _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(tx, px), _mm256_mul_pd(ty, py)), _mm256_mul_pd(tz, pz)), invDet);
+  ok = _mm256_and_pd(ok, _mm256_and_pd(_mm256_cmp_pd(u, zero, _CMP_NLT_UQ), _mm256_cmp_pd(u, one, _CMP_NGT_UQ)));
+
+  // qvec = cross(tvec, edge1)
+  __m256d qx = _mm256_sub_pd(_mm256_mul_pd(ty, e1z), _mm256_mul_pd(tz, e1y));
+  __m256d qy = _mm256_sub_pd(_mm256_mul_pd(tz, e1x), _mm256_mul_pd(tx, e1z));
+  __m256d qz = _mm256_sub_pd(_mm256_mul_pd(tx, e1y), _mm256_mul_pd(ty, e1x));
+  __m256d v = _mm256_mul_pd(
+      _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(dx, qx), _mm256_mul_pd(dy, qy)), _mm256_mul_pd(dz, qz)), invDet);
+  ok = _mm256_and_pd(ok, _mm256_and_pd(_mm256_cmp_pd(v, zero, _CMP_NLT_UQ),
+                                       _mm256_cmp_pd(_mm256_add_pd(u, v), one, _CMP_NGT_UQ)));
+
+  t = _mm256_mul_pd(
+      _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(e2x, qx), _mm256_mul_pd(e2y, qy)), _mm256_mul_pd(e2z, qz)), invDet);
+  return _mm256_and_pd(ok, _mm256_and_pd(_mm256_cmp_pd(t, tMin, _CMP_NLT_UQ), _mm256_cmp_pd(t, tMax, _CMP_NGT_UQ)));
+}
+
+// Recorre los carriles que impactaron en orden, como el bucle escalar: gana el t
+// mas chico y ante empate el ultimo. Devuelve el indice ganador o -1.
+RT_AVX2 inline void pickClosest(__m256d hit, __m256d t, size_t base, double& closest, long& best) {
+  int bits = _mm256_movemask_pd(hit);
+  if (!bits) return;
+  alignas(32) double ts[4];
+  _mm256_store_pd(ts, t);
+  for (int l = 0; l < 4; ++l) {
+    if ((bits >> l) & 1 && !(ts[l] > closest)) {
+      closest = ts[l];
+      best = (long)(base + l);
+    }
+  }
+}
+
+RT_AVX2 inline long closestSphere(const std::vector<SphereLanes>& blocks, const Ray& r, double tMin, double& closest) {
+  __m256d a = _mm256_set1_pd(r.direction.lengthSquared());
+  __m256d lo = _mm256_set1_pd(tMin);
+  long best = -1;
+  for (size_t k = 0; k < blocks.size(); ++k) {
+    __m256d t;
+    __m256d hit = sphereLanes(blocks[k], r, a, lo, _mm256_set1_pd(closest), t);
+    pickClosest(hit, t, k * 4, closest, best);
+  }
+  return best;
+}
+
+RT_AVX2 inline bool anySphere(const std::vector<SphereLanes>& blocks, const Ray& r, double tMin, double tMax) {
+  __m256d a = _mm256_set1_pd(r.direction.lengthSquared());
+  __m256d lo = _mm256_set1_pd(tMin), hi = _mm256_set1_pd(tMax);
+  for (const auto& b : blocks) {
+    __m256d t;
+    __m256d hit = _mm256_and_pd(sphereLanes(b, r, a, lo, hi, t), mask(b.shadow));
+    if (_mm256_movemask_pd(hit)) return true;
+  }
+  return false;
+}
+
+RT_AVX2 inline long closestTriangle(const std::vector<TriangleLanes>& blocks, const Ray& r, double tMin,
+                                    double& closest) {
+  __m256d lo = _mm256_set1_pd(tMin);
+  long best = -1;
+  for (size_t k = 0; k < blocks.size(); ++k) {
+    __m256d t;
+    __m256d hit = triangleLanes(blocks[k], r, lo, _mm256_set1_pd(closest), t);
+    pickClosest(hit, t, k * 4, closest, best);
+  }
+  return best;
+}
+
+RT_AVX2 inline bool anyTriangle(const std::vector<TriangleLanes>& blocks, const Ray& r, double tMin, double tMax) {
+  __m256d lo = _mm256_set1_pd(tMin), hi = _mm256_set1_pd(tMax);
+  for (const auto& b : blocks) {
+    __m256d t;
+    __m256d hit = _mm256_and_pd(triangleLanes(b, r, lo, hi, t), mask(b.shadow));
+    if (_mm256_movemask_pd(hit)) return true;
+  }
+  return false;
+}
+
+#undef RT_AVX2
+
+}
+
+#endif
+
+}
@@ -3,16 +3,17 @@
 #include <memory>
 
 #include "geometry/Hittable.h"
+#include "materials/Material.h"
 
 namespace rt {
 
-class Sphere : public Hittable {
- public:
-  Sphere() = default;
-  Sphere(const Vec3& c, double r, std::shared_ptr<Material> m)
-    : center(c), radius(r), mat(std::move(m)) {}
+// datos planos de la esfera: los usa Sphere y la copia compacta de Scene::freeze
+struct SphereData {
+  Vec3 center{0,0,0};
+  double radius{1.0};
+  const Material* mat{nullptr};
 
-  bool hit(const Ray& r, double tMin, double tMax, HitRecord& rec) const override {
+  inline bool hit(const Ray& r, double tMin, double tMax, HitRecord& rec) const {
     Vec3 oc = r.origin - center;
     double a = r.direction.lengthSquared();
     double half_b = dot(oc, r.direction);
@@ -36,12 +37,46 @@ class Sphere : public Hittable {
     return true;
   }
 
+  inline AABB bounds() const {
+    Vec3 rv{radius, radius, radius};
+    return AABB(center - rv, center + rv);
+  }
+
+  // geometria y material, para las claves de la cache de tiles
+  inline void hashInto(ContentHash& h) const {
+    h.addBits(1);
+    h.add(center);
+    h.add(radius);
+    hashMaterial(h, mat);
+  }
+};
+
+class Sphere : public Hittable {
+ public:
+  Sphere() = default;
+  Sphere(const Vec3& c, double r, std::shared_ptr<Material> m)
+    : data{c, r, m.get()}, mat(std::move(m)) {}
+
+  bool hit(const Ray& r, double tMin, double tMax, HitRecord& rec) const override {
+    return data.hit(r, tMin, tMax, rec);
+  }
+
+  bool boundingBox(AABB& box) const override {
+    box = data.bounds();
+    return true;
+  }
+
+  uint64_t contentHash() const override {
+    ContentHash h;
+    data.hashInto(h);
+    return h.value();
+  }
+
+  const SphereData& shape() const { return data; }
+
  private:
-  Vec3 center{0,0,0};
-  double radius{1.0};
+  SphereData data;
   std::shared_ptr<Material> mat;
 };
 
 }
-
-
@@ -3,22 +3,21 @@
 #include <memory>
 
 #include "geometry/Hittable.h"
+#include "materials/Material.h"
 
 namespace rt {
 
-class Triangle : public Hittable {
- public:
-  Triangle() = default;
-  Triangle(const Vec3& a, const Vec3& b, const Vec3& c, std::shared_ptr<Material> m)
-    : v0(a), v1(b), v2(c), mat(std::move(m)) {
-    normalFace = normalize(cross(v1 - v0, v2 - v0));
-  }
+// datos planos del triangulo con las aristas ya calculadas
+struct TriangleData {
+  Vec3 v0;
+  Vec3 edge1;
+  Vec3 edge2;
+  Vec3 normalFace;
+  const Material* mat{nullptr};
 
-  bool hit(const Ray& r, double tMin, double tMax, HitRecord& rec) const override {
+  inline bool hit(const Ray& r, double tMin, double tMax, HitRecord& rec) const {
     // Moller Trumbore
     const double EPS = 1e-9;
-    Vec3 edge1 = v1 - v0;
-    Vec3 edge2 = v2 - v0;
     Vec3 pvec = cross(r.direction, edge2);
     double det = dot(edge1, pvec);
     if (std::fabs(det) < EPS) return false;
@@ -43,12 +42,54 @@ class Triangle : public Hittable {
     return true;
   }
 
+  inline AABB bounds() const {
+    AABB box(v0, v0 + edge1);
+    box.expand(v0 + edge2);
+    return box.padded();
+  }
+
+  // geometria y material, para las claves de la cache de tiles
+  inline void hashInto(ContentHash& h) const {
+    h.addBits(2);
+    h.add(v0);
+    h.add(edge1);
+    h.add(edge2);
+    hashMaterial(h, mat);
+  }
+};
+
+class Triangle : public Hittable {
+ public:
+  Triangle() = default;
+  Triangle(const Vec3& a, const Vec3& b, const Vec3& c, std::shared_ptr<Material> m)
+    : mat(std::move(m)) {
+    data.v0 = a;
+    data.edge1 = b - a;
+    data.edge2 = c - a;
+    data.normalFace = normalize(cross(data.edge1, data.edge2));
+    data.mat = mat.get();
+  }
+
+  bool hit(const Ray& r, double tMin, double tMax, HitRecord& rec) const override {
+    return data.hit(r, tMin, tMax, rec);
+  }
+
+  bool boundingBox(AABB& box) const override {
+    box = data.bounds();
+    return true;
+  }
+
+  uint64_t contentHash() const override {
+    ContentHash h;
+    data.hashInto(h);
+    return h.value();
+  }
+
+  const TriangleData& shape() const { return data; }
+
  private:
-  Vec3 v0, v1, v2;
-  Vec3 normalFace;
+  TriangleData data;
   std::shared_ptr<Material> mat;
 };
 
 }
-
-
@@ -1,20 +1,39 @@
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <future>
 #include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 #include <memory>
 
+#include <unistd.h>
+
 #include "core/Vec3.h"
 #include "core/Ray.h"
-#include "utils/ImageWriterPPM.h"
 #include "utils/ImageWriterAuto.h"
-#include "geometry/Sphere.h"
-#include "geometry/Triangle.h"
-#include "geometry/Plane.h"
-#include "materials/Material.h"
-#include "lights/PointLight.h"
+#include "utils/AovWriter.h"
 #include "camera/Camera.h"
 #include "scene/Scene.h"
+#include "scene/Presets.h"
+#include "scene/SceneCache.h"
+#include "server/RenderServer.h"
 #include "renderer/Renderer.h"
+#include "renderer/Denoiser.h"
+#include "renderer/Relighter.h"
+#include "renderer/RenderService.h"
+#include "renderer/TileCache.h"
+#include "sampling/Sampler.h"
 
 using namespace rt;
 
@@ -25,9 +44,40 @@ struct Args {
   int maxDepth = 6;
   std::string scene = "final"; // "final" o "base"
   std::string out = "img/output.ppm";
-  std::string camera = "frontal"; // "frontal" | "superior" | "lateral"
+  std::string camera = "frontal"; // "frontal" | "superior" | "lateral", lista separada por comas o @archivo
+  std::string sampler = "random"; // "random" | "stratified" | "halton" | "sobol" | "bluenoise"
+  bool denoise = false;
+  int denoiseIterations = 3;
+  int denoiseThreads = 0;       // 0 = hardware_concurrency; no es un parametro CLI
+  std::vector<std::string> aovs; // "beauty" | "normal" | "depth" | "albedo" | "matid"
+  std::string aovFormat = "ldr"; // "ldr" (mismo formato que --out) | "pfm"
+  double minContribution = 1e-3;
+  bool russianRoulette = false;
+  std::string accum = "rgb32"; // "rgb64" | "rgb32"
+  int bitDepth = 0;            // 8 | 16 bits por canal en PPM binario/PNG (0 = PPM ASCII de 8 bits)
+  std::string serve;           // ruta del socket Unix en modo servidor (vacio = render unico)
+  int sceneCache = 4;          // escenas congeladas que guarda el servidor
+  int workers = 0;             // trabajos simultaneos del servidor (0 = nucleos disponibles)
+  std::string relight;         // archivo con una configuracion de luces por linea (vacio = render normal)
+  std::string simd = "auto";   // "auto" (segun la CPU) | "off" (kernels escalares)
+  std::string tileCache;       // carpeta de la cache de tiles en disco (vacio = sin cache)
+  std::string tileCacheMax;    // tope de la carpeta de la cache, ej. "512M" (vacio = 1G)
+  std::string geometryMemory;  // presupuesto de geometria residente, ej. "8G" (vacio = todo en memoria)
+  std::string geometryDir;     // carpeta de los chunks de geometria (vacio = carpeta temporal)
 };
 
+static std::vector<std::string> splitList(const std::string& s) {
+  std::vector<std::string> out;
+  size_t start = 0;
+  while (start <= s.size()) {
+    size_t comma = s.find(',', start);
+    if (comma == std::string::npos) comma = s.size();
+    if (comma > start) out.push_back(s.substr(start, comma - start));
+    start = comma + 1;
+  }
+  return out;
+}
+
 static Args parseArgs(int argc, char** argv) {
   Args a;
   for (int i = 1; i < argc; ++i) {
@@ -41,225 +91,497 @@ static Args parseArgs(int argc, char** argv) {
     else if (k == "--scene") readStr(a.scene);
     else if (k == "--out") readStr(a.out);
     else if (k == "--camera") readStr(a.camera);
+    else if (k == "--sampler") readStr(a.sampler);
+    else if (k == "--denoise") a.denoise = true;
+    else if (k == "--denoise-iterations") readInt(a.denoiseIterations);
+    else if (k == "--aov") {
+      std::string list;
+      readStr(list);
+      for (const auto& aov : splitList(list)) {
+        if (aov == "all") {
+          for (const char* x : {"normal", "depth", "albedo", "matid"}) a.aovs.push_back(x);
+        } else {
+          a.aovs.push_back(aov);
+        }
+      }
+    }
+    else if (k == "--aov-format") readStr(a.aovFormat);
+    else if (k == "--min-contribution") { if (i+1 < argc) a.minContribution = std::stod(argv[++i]); }
+    else if (k == "--russian-roulette") a.russianRoulette = true;
+    else if (k == "--accum") readStr(a.accum);
+    else if (k == "--bit-depth") readInt(a.bitDepth);
+    else if (k == "--serve") readStr(a.serve);
+    else if (k == "--scene-cache") readInt(a.sceneCache);
+    else if (k == "--workers") readInt(a.workers);
+    else if (k == "--relight") readStr(a.relight);
+    else if (k == "--simd") readStr(a.simd);
+    else if (k == "--tile-cache") readStr(a.tileCache);
+    else if (k == "--tile-cache-max") readStr(a.tileCacheMax);
+    else if (k == "--geometry-memory") readStr(a.geometryMemory);
+    else if (k == "--geometry-dir") readStr(a.geometryDir);
   }
   return a;
 }
 
-// Escena base: plano y tres esferas (difusa, metal, dielectrico)
-static void buildBaseScene(Scene& scene, Camera*& cam, int width, int height, const std::string& cameraView) {
-  // Materiales simples
-  auto sueloMat = std::make_shared<Lambertian>(Vec3{0.75, 0.75, 0.75});
-  auto difusa = std::make_shared<Lambertian>(Vec3{0.80, 0.25, 0.25});
-  auto metal = std::make_shared<Metal>(Vec3{0.90, 0.90, 0.90}, 0.02, 1.0);
-  auto vidrio = std::make_shared<Dielectric>(1.5);
-  // Panel emisivo para que se vea brillante a traves del vidrio
-  auto rojo = std::make_shared<Lambertian>(Vec3{0.5, 0.1, 0.1});
-  rojo->emissive = Vec3{0.75, 0.1, 0.1}; // emite luz roja
-  auto naranja = std::make_shared<Lambertian>(Vec3{0.5, 0.3, 0.1});
-  naranja->emissive = Vec3{0.85, 0.5, 0.1}; // emite luz naranja
-
-  // Planos: suelo y fondo
-  scene.addObject(std::make_shared<Plane>(Vec3{0,1,0}, 0.0, sueloMat));      // y=0
-  scene.addObject(std::make_shared<Plane>(Vec3{0,0,1}, 4.0, sueloMat));      // z=-4
-
-  // Esferas
-  scene.addObject(std::make_shared<Sphere>(Vec3{-0.9, 0.5, -2.4}, 0.5, difusa)); // lambertiana
-  scene.addObject(std::make_shared<Sphere>(Vec3{ 0.0, 0.5, -2.8}, 0.5, metal));  // espejo
-  scene.addObject(std::make_shared<Sphere>(Vec3{ 1.0, 0.5, -2.2}, 0.5, vidrio)); // dielectric
-
-  // Panel de dos colores detras de la esfera de vidrio para verificar refraccion
-  // La esfera de vidrio esta en (1.0, 0.5, -2.2) con radio 0.5
-  // Su parte trasera esta en z = -2.2 - 0.5 = -2.7
-  // El panel debe estar MAS ATRAS que -2.7, pero no muy lejos
-  double zPanel = -3.4;
-  // Panel mas grande y centrado en la esfera de vidrio
-  // Mitad rojo / mitad amarillo: xM es el punto medio entre xL y xR
-  // Lo desplazamos un poco hacia la derecha manteniendo el ancho
-  double dx = 0.30;
-  double xL = 0.2 + dx, xR = 1.8 + dx;
-  double xM = 0.5 * (xL + xR);
-  double yB = -0.2, yT = 1.5;
-  // rectangulo izquierdo (rojo)
-  scene.addObject(std::make_shared<Triangle>(Vec3{xL, yB, zPanel}, Vec3{xM, yB, zPanel}, Vec3{xL, yT, zPanel}, rojo));
-  scene.addObject(std::make_shared<Triangle>(Vec3{xM, yB, zPanel}, Vec3{xM, yT, zPanel}, Vec3{xL, yT, zPanel}, rojo));
-  // rectangulo derecho (naranja)
-  scene.addObject(std::make_shared<Triangle>(Vec3{xM, yB, zPanel}, Vec3{xR, yB, zPanel}, Vec3{xM, yT, zPanel}, naranja));
-  scene.addObject(std::make_shared<Triangle>(Vec3{xR, yB, zPanel}, Vec3{xR, yT, zPanel}, Vec3{xM, yT, zPanel}, naranja));
-
-  // Luces
-  scene.lights.push_back(PointLight{Vec3{0.0, 2.2, -2.2}, Vec3{1,1,1}, 0.9});
-  scene.lights.push_back(PointLight{Vec3{-1.6, 1.6, -3.2}, Vec3{1.0, 0.95, 0.9}, 0.4});
-
-  // Camara: reutilizamos presets para coherencia
-  Vec3 lookAt{0.0, 0.4, -2.6};
-  Vec3 lookFrom;
-  Vec3 vup;
-  auto toLower = [](std::string s){ for (auto& c : s) c = (char)tolower(c); return s; };
-  std::string view = toLower(cameraView);
-  double fovDeg = 50.0;
-  if (view == "frontal" || view == "front") {
-    lookFrom = Vec3{0.0, 1.0, 1.2};
-    vup = Vec3{0.0, 1.0, 0.0};
-  } else if (view == "superior" || view == "top") {
-    lookFrom = Vec3{0.0, 2.2, 0.6};
-    lookAt = Vec3{0.0, 0.25, -2.4};
-    vup = Vec3{0.0, 1.0, 0.0};
-    fovDeg = 70.0;
-  } else if (view == "lateral" || view == "side") {
-    lookFrom = Vec3{-1.8, 1.0, -2.6};
-    vup = Vec3{0.0, 1.0, 0.0};
-    fovDeg = 65.0;
-  } else {
-    lookFrom = Vec3{0.0, 1.0, 1.2};
-    vup = Vec3{0.0, 1.0, 0.0};
+// salida de cada vista cuando se renderizan varias: img/final.png -> img/final_frontal.png
+static std::string outputForView(const std::string& out, const std::string& view) {
+  size_t slash = out.find_last_of('/');
+  size_t dot = out.find_last_of('.');
+  if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) return out + "_" + view;
+  return out.substr(0, dot) + "_" + view + out.substr(dot);
+}
+
+// --camera acepta una lista separada por comas o @archivo con una vista por linea
+static std::vector<std::string> cameraViews(const std::string& spec) {
+  if (spec.empty() || spec[0] != '@') return splitList(spec);
+  std::vector<std::string> views;
+  std::ifstream f(spec.substr(1));
+  std::string line;
+  while (std::getline(f, line)) {
+    line.erase(0, line.find_first_not_of(" \t\r"));
+    line.erase(line.find_last_not_of(" \t\r") + 1);
+    if (!line.empty() && line[0] != '#') views.push_back(line);
   }
-  double aspect = (double)width / (double)height;
-  cam = new Camera(lookFrom, lookAt, vup, fovDeg, aspect);
-  // Fondo mas oscuro para que la refraccion del panel sea mas visible
-  scene.background = Vec3{0.2, 0.2, 0.3};
+  return views;
 }
 
-// Escena final: habitacion de madera con espejo
-static void buildFinalScene(Scene& scene, Camera*& cam, int width, int height, const std::string& cameraView) {
-  // Materiales
-  auto madera = std::make_shared<Lambertian>(Vec3{0.55, 0.36, 0.22});
-  auto marco = std::make_shared<Lambertian>(Vec3{0.05, 0.05, 0.05});
-  auto espejo = std::make_shared<Metal>(Vec3{0.95, 0.95, 0.95}, 0.02, 1.0);
-  auto difRoja = std::make_shared<Lambertian>(Vec3{0.80, 0.25, 0.25});
-  auto metalBlanco = std::make_shared<Metal>(Vec3{0.85, 0.85, 0.85}, 0.05, 1.0);
-  auto vidrio = std::make_shared<Dielectric>(1.5);
-  auto gris = std::make_shared<Lambertian>(Vec3{0.6, 0.6, 0.6});
-  auto lampara = std::make_shared<Lambertian>(Vec3{0.95, 0.95, 0.9});
-  lampara->emissive = Vec3{0.9, 0.9, 0.85};
-  lampara->castsShadow = false;
-
-  // Planos de la habitacion
-  // y = 0 (suelo): n=(0,1,0), d=0
-  scene.addObject(std::make_shared<Plane>(Vec3{0,1,0}, 0.0, madera));
-  // y = 2.5 (techo): n=(0,-1,0), d=2.5
-  scene.addObject(std::make_shared<Plane>(Vec3{0,-1,0}, 2.5, madera));
-  // x = -2.0 (pared izq): n=(1,0,0), d=2.0
-  scene.addObject(std::make_shared<Plane>(Vec3{1,0,0}, 2.0, madera));
-  // x = +2.0 (pared der): n=(-1,0,0), d=2.0
-  scene.addObject(std::make_shared<Plane>(Vec3{-1,0,0}, 2.0, madera));
-  // z = -6.0 (pared fondo): n=(0,0,1), d=6.0
-  scene.addObject(std::make_shared<Plane>(Vec3{0,0,1}, 6.0, madera));
-
-  // espejo en pared de fondo
-  double zMirror = -5.9995;
-  double xL = -1.8, xR = 1.8, yB = 0.2, yT = 2.3;
-  scene.addObject(std::make_shared<Triangle>(Vec3{xL, yB, zMirror}, Vec3{xR, yB, zMirror}, Vec3{xL, yT, zMirror}, espejo));
-  scene.addObject(std::make_shared<Triangle>(Vec3{xR, yB, zMirror}, Vec3{xR, yT, zMirror}, Vec3{xL, yT, zMirror}, espejo));
-
-  // marcos del espejo
-  double zFrame = -5.9993;
-  // marco izquierdo: x in [-2.0, xL], y in [0.0, 2.5]
-  scene.addObject(std::make_shared<Triangle>(Vec3{-2.0, 0.0, zFrame}, Vec3{xL, 0.0, zFrame}, Vec3{-2.0, 2.5, zFrame}, marco));
-  scene.addObject(std::make_shared<Triangle>(Vec3{xL, 0.0, zFrame}, Vec3{xL, 2.5, zFrame}, Vec3{-2.0, 2.5, zFrame}, marco));
-  // marco derecho: x in [xR, 2.0]
-  scene.addObject(std::make_shared<Triangle>(Vec3{xR, 0.0, zFrame}, Vec3{2.0, 0.0, zFrame}, Vec3{xR, 2.5, zFrame}, marco));
-  scene.addObject(std::make_shared<Triangle>(Vec3{2.0, 0.0, zFrame}, Vec3{2.0, 2.5, zFrame}, Vec3{xR, 2.5, zFrame}, marco));
-  // marco inferior: y in [0.0, yB], x in [xL, xR]
-  scene.addObject(std::make_shared<Triangle>(Vec3{xL, 0.0, zFrame}, Vec3{xR, 0.0, zFrame}, Vec3{xL, yB, zFrame}, marco));
-  scene.addObject(std::make_shared<Triangle>(Vec3{xR, 0.0, zFrame}, Vec3{xR, yB, zFrame}, Vec3{xL, yB, zFrame}, marco));
-  // marco superior: y in [yT, 2.5], x in [xL, xR]
-  scene.addObject(std::make_shared<Triangle>(Vec3{xL, yT, zFrame}, Vec3{xR, yT, zFrame}, Vec3{xL, 2.5, zFrame}, marco));
-  scene.addObject(std::make_shared<Triangle>(Vec3{xR, yT, zFrame}, Vec3{xR, 2.5, zFrame}, Vec3{xL, 2.5, zFrame}, marco));
-
-  // lampara de techo
-  double yLamp = 2.30;
-  double xl0 = -0.35, xr0 = 0.35, zf0 = -3.6, zn0 = -2.8;
-  scene.addObject(std::make_shared<Triangle>(Vec3{xl0, yLamp, zf0}, Vec3{xr0, yLamp, zf0}, Vec3{xl0, yLamp, zn0}, lampara));
-  scene.addObject(std::make_shared<Triangle>(Vec3{xr0, yLamp, zf0}, Vec3{xr0, yLamp, zn0}, Vec3{xl0, yLamp, zn0}, lampara));
-
-  // lampara lateral
-  double xLamp2 = -1.9993;
-  double yL2b = 1.1, yL2t = 1.7;
-  double zL2n = -2.6, zL2f = -3.2;
-  scene.addObject(std::make_shared<Triangle>(Vec3{xLamp2, yL2b, zL2n}, Vec3{xLamp2, yL2t, zL2n}, Vec3{xLamp2, yL2b, zL2f}, lampara));
-  scene.addObject(std::make_shared<Triangle>(Vec3{xLamp2, yL2t, zL2n}, Vec3{xLamp2, yL2t, zL2f}, Vec3{xLamp2, yL2b, zL2f}, lampara));
-
-  // esferas
-  scene.addObject(std::make_shared<Sphere>(Vec3{-0.8, 0.5, -2.2}, 0.5, difRoja));
-  // metal especular
-  metalBlanco->reflectivity = 1.0;
-  scene.addObject(std::make_shared<Sphere>(Vec3{1.1, 0.5, -2.8}, 0.5, metalBlanco));
-
-  // triangulos adicionales
-  // triangulo apoyado en el piso, rotado levemente para ver dos caras (una especie de tetraedro)
-  Vec3 tA{-0.35, 0.0, -1.42}; // base izquierda en el piso
-  Vec3 tB{ 0.35, 0.0, -1.55}; // base derecha en el piso
-  Vec3 tC{ 0.00, 0.58, -1.50}; // punta superior
-  scene.addObject(std::make_shared<Triangle>(tA, tB, tC, gris));
-  // segunda cara, base invertida para formar la punta
-  Vec3 tB2{-0.35, 0.0, -1.55};
-  Vec3 tA2{ 0.35, 0.0, -1.42};
-  scene.addObject(std::make_shared<Triangle>(tA2, tB2, tC, gris));
-
-  // luz puntual principal (techo)
-  scene.lights.push_back(PointLight{Vec3{0.0, 2.22, -3.2}, Vec3{1,1,1}, 0.9});
-  // segunda luz puntual, alineada con la lampara de pared
-  scene.lights.push_back(PointLight{Vec3{-1.90, 1.40, -2.90}, Vec3{1.0, 0.9, 0.8}, 0.4});
-
-  // camara pinhole
-  Vec3 lookAt{0.0, 0.7, -3.2};
-  Vec3 lookFrom;
-  Vec3 vup;
-  // elegir preset de camara sin modificar la escena
-  auto toLower = [](std::string s){ for (auto& c : s) c = (char)tolower(c); return s; };
-  std::string view = toLower(cameraView);
-  double fovDeg = 45.0;
-  if (view == "frontal" || view == "front") {
-    lookFrom = Vec3{0.0, 1.0, 1.8};
-    vup = Vec3{0.0, 1.0, 0.0};
-  } else if (view == "superior" || view == "top") {
-    // vista superior con un poquito de inclinacion para ver bien todos los objetos
-    // para mantenernos abajo del techo seteo y < 2.5 y se abre mas el fov (75)
-    lookFrom = Vec3{0.0, 2.45, 1.0};
-    // inclinar mas hacia el piso bajando el punto de interes
-    lookAt = Vec3{0.0, 0.30, -2.4};
-    vup = Vec3{0.0, 1.0, 0.0};
-    fovDeg = 75.0;
-  } else if (view == "lateral" || view == "side") {
-    // vista lateral desde la izquierda mirando hacia el centro
-    // no podemos superar x=-2.0 (pared izquierda). Alejamos un poco y abrimos FOV.
-    lookFrom = Vec3{-1.95, 1.0, -3.2};
-    vup = Vec3{0.0, 1.0, 0.0};
-    fovDeg = 70.0;
-  } else {
-    // por defecto, frontal
-    lookFrom = Vec3{0.0, 1.0, 1.8};
-    vup = Vec3{0.0, 1.0, 0.0};
+// --relight: una configuracion de luces por linea, luces separadas por ';' y
+// cada luz como "x y z r g b intensidad"; lineas vacias o con '#' se ignoran
+static bool lightSetups(const std::string& path, std::vector<std::vector<PointLight>>& setups, std::string& err) {
+  std::ifstream f(path);
+  if (!f) {
+    err = "no se pudo leer " + path;
+    return false;
+  }
+  std::string line;
+  int lineNo = 0;
+  while (std::getline(f, line)) {
+    ++lineNo;
+    size_t hash = line.find('#');
+    if (hash != std::string::npos) line.erase(hash);
+    if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+    std::vector<PointLight> lights;
+    std::stringstream ls(line);
+    std::string item;
+    while (std::getline(ls, item, ';')) {
+      if (item.find_first_not_of(" \t\r") == std::string::npos) continue;
+      std::istringstream in(item);
+      PointLight l;
+      if (!(in >> l.position.x >> l.position.y >> l.position.z >> l.color.x >> l.color.y >> l.color.z >> l.intensity)) {
+        err = path + ":" + std::to_string(lineNo) + ": se esperaba \"x y z r g b intensidad\"";
+        return false;
+      }
+      lights.push_back(l);
+    }
+    setups.push_back(lights);
   }
-  double aspect = (double)width / (double)height;
-  cam = new Camera(lookFrom, lookAt, vup, fovDeg, aspect);
+  if (setups.empty()) {
+    err = "no hay configuraciones de luces en " + path;
+    return false;
+  }
+  return true;
+}
 
-  // fondo
-  scene.background = Vec3{0.7, 0.8, 1.0};
+static std::mutex logMutex;
+
+// destino de los mensajes de un trabajo: la consola en modo CLI o el socket del
+// cliente en modo servidor
+struct JobOutput {
+  std::function<void(const std::string&)> info;
+  std::function<void(const std::string&)> error;
+  std::function<void(int)> progress; // porcentaje por fila; nulo = sin progreso
+};
+
+static JobOutput consoleOutput() {
+  JobOutput o;
+  o.info = [](const std::string& msg) {
+    std::lock_guard<std::mutex> lock(logMutex);
+    std::cout << msg << "\n";
+  };
+  o.error = [](const std::string& msg) {
+    std::lock_guard<std::mutex> lock(logMutex);
+    std::cerr << msg << "\n";
+  };
+  return o;
 }
 
-int main(int argc, char** argv) {
-  Args args = parseArgs(argc, argv);
+// tamanio en bytes con sufijo opcional K, M o G (potencias de 1024): "512M", "8G"
+static bool parseByteSize(const std::string& s, size_t& out) {
+  if (s.empty() || !std::isdigit((unsigned char)s[0])) return false;
+  size_t pos = 0;
+  unsigned long long n;
+  try {
+    n = std::stoull(s, &pos);
+  } catch (const std::exception&) {
+    return false; // fuera de rango
+  }
+  std::string suffix = s.substr(pos);
+  unsigned shift = 0;
+  if (suffix == "K" || suffix == "k") shift = 10;
+  else if (suffix == "M" || suffix == "m") shift = 20;
+  else if (suffix == "G" || suffix == "g") shift = 30;
+  else if (!suffix.empty()) return false;
+  if (n == 0 || n > (SIZE_MAX >> shift)) return false;
+  out = (size_t)n << shift;
+  return true;
+}
+
+// mismas validaciones para la linea de comandos y para los pedidos al servidor
+static bool validateArgs(const Args& args, std::string& err) {
+  if (!makeSampler(args.sampler)) {
+    err = "sampler desconocido " + args.sampler;
+    return false;
+  }
+  for (const auto& aov : args.aovs) {
+    if (!AovWriter::isKnown(aov)) {
+      err = "aov desconocido " + aov;
+      return false;
+    }
+  }
+  PixelFormat fmt;
+  if (!parsePixelFormat(args.accum, fmt)) {
+    err = "formato de acumulacion desconocido " + args.accum;
+    return false;
+  }
+  if (args.bitDepth != 0 && args.bitDepth != 8 && args.bitDepth != 16) {
+    err = "--bit-depth debe ser 8 o 16";
+    return false;
+  }
+  if (args.simd != "auto" && args.simd != "off") {
+    err = "--simd debe ser auto u off";
+    return false;
+  }
+  size_t budget;
+  if (!args.tileCacheMax.empty() && !parseByteSize(args.tileCacheMax, budget)) {
+    err = "--tile-cache-max espera un tamanio como 512M o 2G";
+    return false;
+  }
+  if (!args.geometryMemory.empty() && !parseByteSize(args.geometryMemory, budget)) {
+    err = "--geometry-memory espera un tamanio como 512M u 8G";
+    return false;
+  }
+  if (args.width <= 0 || args.height <= 0 || args.spp <= 0) {
+    err = "--width, --height y --spp deben ser positivos";
+    return false;
+  }
+  return true;
+}
 
-  // crear escena segun seleccion
-  Scene scene;
+static Renderer makeRenderer(const Args& args, const std::shared_ptr<Sampler>& sampler) {
+  Renderer renderer(args.width, args.height, args.spp, args.maxDepth);
+  parsePixelFormat(args.accum, renderer.format);
+  renderer.sampler = sampler;
+  renderer.integrator.minContribution = args.minContribution;
+  renderer.integrator.russianRoulette = args.russianRoulette;
+  return renderer;
+}
 
-  Camera* cam = nullptr;
-  if (args.scene == "base") {
-    buildBaseScene(scene, cam, args.width, args.height, args.camera);
+// denoiser opcional y escritura de la imagen y de los AOVs pedidos
+static bool writeOutputs(Framebuffer& pixels, const AuxBuffers& aux, const Args& args, const std::string& out,
+                         const JobOutput& log) {
+  if (args.denoise) {
+    DenoiseSettings ds;
+    ds.iterations = args.denoiseIterations;
+    ds.threads = args.denoiseThreads;
+    Denoiser(ds).apply(pixels, aux);
+  }
+  if (!ImageWriterAuto::write(out, pixels, true, args.bitDepth)) {
+    log.error("error: no se pudo escribir la imagen en " + out);
+    return false;
+  }
+  log.info("listo: " + out);
+  bool asFloat = args.aovFormat == "pfm";
+  for (const auto& aov : args.aovs) {
+    std::string path = AovWriter::pathFor(out, aov, asFloat);
+    if (!AovWriter::write(out, aov, pixels, aux, asFloat, args.bitDepth)) {
+      log.error("error: no se pudo escribir el aov " + aov + " en " + path);
+      return false;
+    }
+    log.info("listo: " + path);
+  }
+  return true;
+}
+
+static bool needsAux(const Args& args) { return args.denoise || !args.aovs.empty(); }
+
+static std::shared_ptr<TileCache> makeTileCache(const Args& args) {
+  size_t maxBytes = TileCache::kDefaultMaxBytes;
+  if (!args.tileCacheMax.empty()) parseByteSize(args.tileCacheMax, maxBytes);
+  return std::make_shared<TileCache>(args.tileCache, maxBytes);
+}
+
+static std::string cacheSummary(const TileCacheStats& st) {
+  std::string s = "cache de tiles: " + std::to_string(st.hits) + " aciertos, " + std::to_string(st.misses) + " fallos";
+  if (st.uncached) s += ", " + std::to_string(st.uncached) + " sin cache";
+  return s;
+}
+
+// renderiza una vista en el hilo que llama (modo servidor) y escribe sus archivos
+// (tiles es la cache de tiles del pedido o nulo)
+static bool renderView(const Scene& scene, const Camera& cam, const Args& args,
+                       const std::shared_ptr<Sampler>& sampler, const std::string& out, const JobOutput& log,
+                       TileCache* tiles) {
+  Renderer renderer = makeRenderer(args, sampler);
+  renderer.onProgress = log.progress;
+  // una sola pasada llena la imagen final y todos los AOVs pedidos
+  AuxBuffers aux;
+  AuxBuffers* auxPtr = needsAux(args) ? &aux : nullptr;
+  Framebuffer pixels;
+  if (tiles) {
+    TileCacheStats st;
+    pixels = tiles->render(scene, cam, renderer, RenderMode::Final, auxPtr, RenderOptions{}.tileSize, &st);
+    log.info(cacheSummary(st));
   } else {
-    buildFinalScene(scene, cam, args.width, args.height, args.camera);
+    pixels = renderer.render(scene, cam, RenderMode::Final, auxPtr);
   }
-  Renderer renderer(args.width, args.height, args.spp, args.maxDepth);
-  auto pixels = renderer.render(scene, *cam, RenderMode::Final);
-  bool ok = ImageWriterAuto::write(args.out, args.width, args.height, pixels, true);
-  delete cam;
-  if (!ok) {
-    std::cerr << "error: no se pudo escribir la imagen en " << args.out << "\n";
+  return writeOutputs(pixels, aux, args, out, log);
+}
+
+// Re-iluminacion: un frame por configuracion de luces; solo el primero traza los
+// rayos de camara, los siguientes reutilizan el G-buffer (ver Relighter)
+static int relightFrames(Scene& scene, const Args& args, const std::shared_ptr<Sampler>& sampler,
+                         const std::vector<std::string>& views) {
+  std::vector<std::vector<PointLight>> setups;
+  std::string err;
+  if (!lightSetups(args.relight, setups, err)) {
+    std::cerr << "error: " << err << "\n";
     return 1;
   }
-  std::cout << "listo: " << args.out << "\n";
+  if (views.size() != 1 || args.denoise || !args.aovs.empty()) {
+    std::cerr << "error: --relight admite una sola camara y no se combina con --denoise ni --aov\n";
+    return 1;
+  }
+  Relighter relighter(makeRenderer(args, sampler));
+  Camera cam = makeCamera(args.scene, views[0], args.width, args.height);
+
+  for (size_t k = 0; k < setups.size(); ++k) {
+    scene.lights = setups[k];
+    auto t0 = std::chrono::steady_clock::now();
+    Framebuffer pixels = k == 0 ? relighter.capture(scene, cam) : relighter.relight(scene);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    std::string out = outputForView(args.out, "l" + std::to_string(k));
+    if (!ImageWriterAuto::write(out, pixels, true, args.bitDepth)) {
+      std::cerr << "error: no se pudo escribir la imagen en " << out << "\n";
+      return 1;
+    }
+    std::cout << "listo: " << out << " (" << (int)ms << " ms, luces recalculadas " << relighter.lightsUpdated
+              << "/" << scene.lights.size() << ", muestras con rebotes " << relighter.retraced << ")\n";
+  }
+  std::cout << "g-buffer: " << relighter.bytes() / (1024 * 1024) << " MiB\n";
   return 0;
 }
 
+// Modo servidor: las escenas quedan congeladas en memoria entre pedidos y cada
+// pedido es una linea con los mismos argumentos de la linea de comandos
+static int serve(const Args& serverArgs) {
+  SceneCache cache((size_t)std::max(1, serverArgs.sceneCache));
+  // una cache de tiles por carpeta, compartida por todos los pedidos que la nombran
+  // (el tope de la carpeta es el del primer pedido que la usa)
+  std::mutex tileCachesMutex;
+  std::map<std::string, std::shared_ptr<TileCache>> tileCaches;
+  auto tileCacheFor = [&](const Args& args) -> std::shared_ptr<TileCache> {
+    if (args.tileCache.empty()) return nullptr;
+    std::lock_guard<std::mutex> lock(tileCachesMutex);
+    auto& tc = tileCaches[args.tileCache];
+    if (!tc) tc = makeTileCache(args);
+    return tc;
+  };
+  unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+  size_t numWorkers = serverArgs.workers > 0 ? (size_t)serverArgs.workers : hw;
+
+  auto handler = [&](const std::vector<std::string>& tokens, const RenderServer::Reply& reply) {
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<char*> argv{const_cast<char*>("raytracer")};
+    for (const auto& t : tokens) argv.push_back(const_cast<char*>(t.c_str()));
+    Args args = parseArgs((int)argv.size(), argv.data());
+    std::string err;
+    if (!validateArgs(args, err)) {
+      reply("error: " + err);
+      return false;
+    }
+    if (!args.geometryMemory.empty()) {
+      reply("error: --geometry-memory no se usa en modo servidor (las escenas quedan en memoria)");
+      return false;
+    }
+    // opciones del proceso servidor o de otros modos: en un pedido no tendrian efecto
+    for (const auto& t : tokens) {
+      if (t == "--serve" || t == "--relight" || t == "--scene-cache" || t == "--workers") {
+        reply("error: " + t + " no se admite en un pedido al servidor");
+        return false;
+      }
+    }
+    std::vector<std::string> views = cameraViews(args.camera);
+    if (views.empty()) {
+      reply("error: no hay vistas de camara en " + args.camera);
+      return false;
+    }
+    // varios pedidos corren a la vez: el denoiser de cada uno usa su parte de los nucleos
+    args.denoiseThreads = (int)std::max<size_t>(1, hw / numWorkers);
+
+    bool cached = false;
+    auto scene = cache.get(args.scene, &cached);
+    reply("escena " + args.scene + (cached ? " en cache" : " construida") + " (aciertos " +
+          std::to_string(cache.hitCount()) + ", fallos " + std::to_string(cache.missCount()) + ")");
+
+    int lastPercent = -1;
+    JobOutput log;
+    log.info = reply;
+    log.error = reply;
+    log.progress = [&](int percent) {
+      // una linea cada 10% para no inundar el socket
+      if (percent / 10 == lastPercent / 10) return;
+      lastPercent = percent;
+      reply("progreso " + std::to_string(percent));
+    };
+
+    auto sampler = makeSampler(args.sampler);
+    auto tiles = tileCacheFor(args);
+    bool ok = true;
+    for (const auto& view : views) {
+      lastPercent = -1;
+      Camera cam = makeCamera(args.scene, view, args.width, args.height);
+      std::string out = views.size() == 1 ? args.out : outputForView(args.out, view);
+      if (!renderView(*scene, cam, args, sampler, out, log, tiles.get())) ok = false;
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    reply("tiempo " + std::to_string(ms) + " ms");
+    return ok;
+  };
+
+  RenderServer server(serverArgs.serve, handler, numWorkers);
+  return server.run() ? 0 : 1;
+}
+
+// Modo fuera de memoria: antes de construir la escena, manda su geometria acotada
+// a chunks en disco a medida que se agrega (ver PrimitiveArena::streamTo)
+static std::string geometryChunkPath(const Args& args) {
+  namespace fs = std::filesystem;
+  fs::path dir = args.geometryDir.empty() ? fs::temp_directory_path() : fs::path(args.geometryDir);
+  std::error_code ec;
+  fs::create_directories(dir, ec);
+  return (dir / ("rt-geometria-" + std::to_string(getpid()) + ".chunks")).string();
+}
+
+static bool streamGeometry(Scene& scene, const Args& args) {
+  size_t budget = 0;
+  parseByteSize(args.geometryMemory, budget);
+  std::string path = geometryChunkPath(args);
+  if (!scene.geometry.streamTo(path, budget)) {
+    std::cerr << "error: no se pudo crear el archivo de paso de la geometria junto a " << path << "\n";
+    return false;
+  }
+  return true;
+}
+
+// despues de freeze: los chunks quedaron escritos
+static bool checkStreamedGeometry(const Scene& scene, const Args& args) {
+  const ChunkStore* chunks = scene.geometry.chunks();
+  if (!chunks) {
+    std::cerr << "error: no se pudieron escribir los chunks de geometria en " << geometryChunkPath(args) << "\n";
+    return false;
+  }
+  size_t budget = 0;
+  parseByteSize(args.geometryMemory, budget);
+  std::cout << "geometria: " << chunks->primitiveCount() << " primitivas en " << chunks->stats().chunks
+            << " chunks, presupuesto " << budget / 1024 << " KiB\n";
+  return true;
+}
+
+// metricas de paginado al terminar; un chunk ilegible invalida el frame
+static int reportGeometry(const Scene& scene, int rc) {
+  const ChunkStore* chunks = scene.geometry.chunks();
+  if (!chunks) return rc;
+  const ChunkStats st = chunks->stats();
+  std::cout << "geometria: " << st.pageIns << " lecturas de chunks (" << st.bytesRead / 1024 << " KiB, "
+            << (int)std::round(st.ioMillis) << " ms), " << st.evictions << " desalojos, pico residente "
+            << st.peakResidentBytes / 1024 << " KiB\n";
+  if (st.readErrors) {
+    std::cerr << "error: " << st.readErrors << " chunks de geometria no se pudieron leer; la imagen no es valida\n";
+    return 1;
+  }
+  return rc;
+}
+
+int main(int argc, char** argv) {
+  // cliente: el resto de los argumentos se manda tal cual al servidor
+  if (argc >= 3 && std::string(argv[1]) == "--client") {
+    std::string request;
+    for (int i = 3; i < argc; ++i) request += (i > 3 ? " " : "") + std::string(argv[i]);
+    if (request.empty()) request = "estado";
+    return runRenderClient(argv[2], request, std::cout) ? 0 : 1;
+  }
 
+  Args args;
+  try {
+    args = parseArgs(argc, argv);
+  } catch (const std::exception&) {
+    std::cerr << "error: argumento numerico invalido\n";
+    return 1;
+  }
+  // el nivel de SIMD es del proceso: en modo servidor vale para todos los pedidos
+  if (args.simd == "off") activeSimd() = SimdLevel::Scalar;
+  if (!args.serve.empty()) return serve(args);
+
+  std::string err;
+  if (!validateArgs(args, err)) {
+    std::cerr << "error: " << err << "\n";
+    return 1;
+  }
+  auto sampler = makeSampler(args.sampler);
+  std::vector<std::string> views = cameraViews(args.camera);
+  if (views.empty()) {
+    std::cerr << "error: no hay vistas de camara en " << args.camera << "\n";
+    return 1;
+  }
+
+  // la escena se construye una sola vez y se comparte entre todas las vistas
+  auto scene = std::make_shared<Scene>();
+  const bool outOfCore = !args.geometryMemory.empty();
+  if (outOfCore && !streamGeometry(*scene, args)) return 1;
+  buildScene(args.scene, *scene);
+  scene->freeze();
+  if (outOfCore && !checkStreamedGeometry(*scene, args)) return 1;
+
+  if (!args.relight.empty()) return reportGeometry(*scene, relightFrames(*scene, args, sampler, views));
+
+  // todas las vistas van al mismo servicio: los hilos se reparten los tiles de todas
+  RenderService service;
+  Renderer settings = makeRenderer(args, sampler);
+  RenderOptions opts;
+  opts.withAux = needsAux(args);
+  if (!args.tileCache.empty()) opts.cache = makeTileCache(args);
+  std::vector<std::shared_ptr<RenderJob>> jobs;
+  for (const auto& view : views) {
+    jobs.push_back(service.submit(scene, makeCamera(args.scene, view, args.width, args.height), settings, opts));
+  }
+
+  // el progreso se consulta desde este hilo; los hilos de render no escriben en stdout
+  if (views.size() == 1) {
+    int shown = -1;
+    while (jobs[0]->resultFuture().wait_for(std::chrono::milliseconds(100)) != std::future_status::ready) {
+      int percent = (int)std::round(100.0 * jobs[0]->progress());
+      if (percent == shown) continue;
+      shown = percent;
+      std::cout << "\rprogreso: " << percent << "%" << std::flush;
+    }
+    std::cout << "\rprogreso: 100%\n";
+  }
+
+  bool allOk = true;
+  JobOutput log = consoleOutput();
+  for (size_t k = 0; k < views.size(); ++k) {
+    RenderResult res = jobs[k]->wait();
+    std::string out = views.size() == 1 ? args.out : outputForView(args.out, views[k]);
+    if (!res.error.empty()) {
+      log.error("error: no se pudo renderizar " + out + " (" + res.error + ")");
+      allOk = false;
+      continue;
+    }
+    if (opts.cache) log.info(cacheSummary(res.cache));
+    if (!writeOutputs(res.pixels, res.aux, args, out, log)) allOk = false;
+  }
+  if (opts.cache && opts.cache->evictedFiles() > 0) {
+    log.info("cache de tiles: " + std::to_string(opts.cache->evictedFiles()) + " archivos viejos borrados por el tope");
+  }
+  return reportGeometry(*scene, allOk ? 0 : 1);
+}
@@ -1,9 +1,19 @@
 #pragma once
 
+#include <cstdint>
+#include <cstring>
+
 #include "core/Vec3.h"
+#include "utils/ContentHash.h"
+#include "utils/Random.h"
 
 namespace rt {
 
+// familias de sombreado; el integrador tiene un kernel especializado para cada una
+// Diffuse: solo Phong, Mirror: Phong + reflexion,
+// Dielectric: reflexion + refraccion, Transmissive: solo refraccion
+enum class MaterialKind : uint8_t { Diffuse, Mirror, Dielectric, Transmissive };
+
 // material base con parametros para Phong y propiedades de reflexion/refraccion
 class Material {
  public:
@@ -27,8 +37,54 @@ class Material {
 
   inline bool isReflective() const { return reflectivity > 0.0; }
   inline bool isRefractive() const { return transparency > 0.0; }
+
+  // se deriva de los coeficientes, asi sigue valiendo si se editan despues de construir
+  inline MaterialKind kind() const {
+    if (isRefractive()) return isReflective() ? MaterialKind::Dielectric : MaterialKind::Transmissive;
+    return isReflective() ? MaterialKind::Mirror : MaterialKind::Diffuse;
+  }
+
+  // todos los parametros en un orden fijo (id y claves de la cache de tiles)
+  static constexpr int kParamCount = 24;
+  void params(double (&vals)[kParamCount]) const {
+    const double v[kParamCount] = {Ka.x, Ka.y, Ka.z, Kd.x, Kd.y, Kd.z, Ks.x, Ks.y, Ks.z, shininess,
+                                   reflectivity, transparency, ior, fuzz,
+                                   transmissionTint.x, transmissionTint.y, transmissionTint.z,
+                                   absorption.x, absorption.y, absorption.z,
+                                   emissive.x, emissive.y, emissive.z, castsShadow ? 1.0 : 0.0};
+    std::memcpy(vals, v, sizeof v);
+  }
+
+  void hashInto(ContentHash& h) const {
+    double vals[kParamCount];
+    params(vals);
+    for (double d : vals) h.add(d);
+  }
+
+  // identificador estable de 24 bits derivado de los parametros (AOV de material):
+  // materiales con los mismos parametros comparten id y el valor entra exacto en un float
+  uint32_t id() const {
+    double vals[kParamCount];
+    params(vals);
+    uint32_t h = 0x2545f491u;
+    for (double d : vals) {
+      uint64_t bits;
+      std::memcpy(&bits, &d, sizeof bits);
+      h = hashCombine(h, (uint32_t)bits);
+      h = hashCombine(h, (uint32_t)(bits >> 32));
+    }
+    // 0 queda reservado para "sin impacto"
+    h &= 0xffffffu;
+    return h ? h : 1u;
+  }
 };
 
+// contenido de un material para claves de cache (nullptr tambien es un valor)
+inline void hashMaterial(ContentHash& h, const Material* m) {
+  if (m) m->hashInto(h);
+  else h.addBits(0);
+}
+
 class Lambertian : public Material {
  public:
   Lambertian(const Vec3& color) {
@@ -71,5 +127,3 @@ class Dielectric : public Material {
 };
 
 }
-
-
@@ -0,0 +1,216 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "core/Vec3.h"
+#include "renderer/Renderer.h"
+
+namespace rt {
+
+struct DenoiseSettings {
+  int iterations{3};        // pasadas A-Trous (radio efectivo 2^iter)
+  float sigmaColor{0.1f};   // se divide por 2 en cada pasada
+  float sigmaNormal{0.3f};
+  float sigmaAlbedo{0.1f};
+  float sigmaDepth{0.05f};  // relativa a la profundidad del pixel central
+  int threads{0};           // 0 = hardware_concurrency
+};
+
+// Filtro A-Trous (Dammertz et al. 2010) guiado por normal, albedo y profundidad
+// del primer impacto. Los datos se pasan a estructura de arreglos en float y cada
+// fila de un tap se parte en tres tramos: los dos bordes, donde el vecino es la
+// columna extrema repetida, y el interior, donde el vecino de x es x + off sin
+// clamp. Asi el bucle no tiene saltos y, con expNeg en vez de std::exp, GCC -O3 lo
+// vectoriza (se ve con -fopt-info-vec). Las filas se reparten entre hilos que se
+// crean una vez por apply y se esperan entre pasadas.
+class Denoiser {
+ public:
+  explicit Denoiser(const DenoiseSettings& s = DenoiseSettings{}) : settings(s) {}
+
+  void apply(Framebuffer& pixels, const AuxBuffers& aux) const {
+    const int width = pixels.width, height = pixels.height;
+    const size_t n = pixels.size();
+    Planes a(n, 3), b(n, 3), normal(n, 3), albedo(n, 3);
+    for (size_t k = 0; k < n; ++k) {
+      a.set(k, pixels.get(k));
+      normal.set(k, aux.normal.get(k));
+      albedo.set(k, aux.albedo.get(k));
+    }
+    const std::vector<float>& depth = aux.depth;
+
+    // las pasadas alternan entre a y b; cada hilo espera a los demas antes de leer
+    // lo que escribio la pasada anterior
+    int nt = settings.threads > 0 ? settings.threads : (int)std::thread::hardware_concurrency();
+    nt = std::max(1, std::min(nt, height));
+    Barrier barrier(nt);
+    auto rows = [&](int t) {
+      const int chunk = (height + nt - 1) / nt;
+      const int y0 = std::min(height, t * chunk), y1 = std::min(height, y0 + chunk);
+      float sigmaC = settings.sigmaColor;
+      for (int it = 0; it < settings.iterations; ++it) {
+        const Planes& in = it % 2 ? b : a;
+        Planes& out = it % 2 ? a : b;
+        filterRows(in, out, normal, albedo, depth, width, height, 1 << it, 1.0f / (sigmaC * sigmaC), y0, y1);
+        sigmaC *= 0.5f;
+        barrier.wait();
+      }
+    };
+    std::vector<std::thread> pool;
+    for (int t = 1; t < nt; ++t) pool.emplace_back(rows, t);
+    rows(0);
+    for (auto& th : pool) th.join();
+
+    const Planes& result = settings.iterations % 2 ? b : a;
+    for (size_t k = 0; k < n; ++k) pixels.set(k, result.get(k));
+  }
+
+  // e^-t para t >= 0 sin llamadas: 2^(-t log2 e) con la parte entera en el
+  // exponente del float y la fraccionaria por Taylor de grado 6 (error relativo
+  // < 4e-5, de sobra para un peso). Por encima de 87 satura en ~1e-38. El tope se
+  // aplica con mascaras sobre los bits (para t >= 0 ordenan igual que el valor; un
+  // NaN tambien va al tope): con un min o una comparacion en float GCC deja un salto
+  // en el bucle y no lo vectoriza.
+  static inline float expNeg(float t) {
+    uint32_t tb;
+    std::memcpy(&tb, &t, sizeof tb);
+    const uint32_t cap = 0x42ae0000u; // 87.0f
+    const uint32_t over = 0u - (uint32_t)(tb > cap);
+    tb = (tb & ~over) | (cap & over);
+    std::memcpy(&t, &tb, sizeof t);
+    float v = t * -1.44269504f; // en [-125.6, 0]
+    int32_t i = (int32_t)v;     // trunca hacia 0: v - i en (-1, 0]
+    float g = (v - (float)i) * 0.69314718f;
+    float e = 1.0f + g * (1.0f + g * (0.5f + g * (1.0f / 6 + g * (1.0f / 24 + g * (1.0f / 120 + g * (1.0f / 720))))));
+    int32_t bits = (i + 127) << 23;
+    float scale;
+    std::memcpy(&scale, &bits, sizeof scale);
+    return e * scale;
+  }
+
+  DenoiseSettings settings;
+
+ private:
+  // canales separados: c[0][k], c[1][k], c[2][k]
+  struct Planes {
+    Planes(size_t n, int ch) : c(ch, std::vector<float>(n)) {}
+    void set(size_t k, const Vec3& v) { c[0][k] = (float)v.x; c[1][k] = (float)v.y; c[2][k] = (float)v.z; }
+    Vec3 get(size_t k) const { return Vec3{c[0][k], c[1][k], c[2][k]}; }
+    std::vector<std::vector<float>> c;
+  };
+
+  // los hilos de apply se esperan aca al terminar cada pasada
+  class Barrier {
+   public:
+    explicit Barrier(int count) : total(count) {}
+    void wait() {
+      std::unique_lock<std::mutex> lock(mtx);
+      const uint64_t gen = generation;
+      if (++arrived == total) {
+        arrived = 0;
+        ++generation;
+        cv.notify_all();
+        return;
+      }
+      cv.wait(lock, [&] { return generation != gen; });
+    }
+
+   private:
+    std::mutex mtx;
+    std::condition_variable cv;
+    int total;
+    int arrived{0};
+    uint64_t generation{0};
+  };
+
+  // un pixel de cada plano: el central (p) o el vecino (q) al principio del tramo
+  struct Texel {
+    const float *r, *g, *b, *nx, *ny, *nz, *ar, *ag, *ab, *z;
+    Texel at(size_t k) const {
+      return Texel{r + k, g + k, b + k, nx + k, ny + k, nz + k, ar + k, ag + k, ab + k, z + k};
+    }
+  };
+
+  struct TapWeights {
+    float h, invC, invN, invA, depthScale;
+  };
+
+  // Suma un tap sobre count pixeles de la fila. QStride 1: el vecino avanza con el
+  // pixel (interior); QStride 0: es siempre el mismo (columna de borde repetida).
+  template <int QStride>
+  static void accumulate(const Texel& p, const Texel& q, int count, const TapWeights& k,
+                         float* __restrict sr, float* __restrict sg, float* __restrict sb, float* __restrict sw) {
+    const float *__restrict pr = p.r, *__restrict pg = p.g, *__restrict pb = p.b;
+    const float *__restrict pnx = p.nx, *__restrict pny = p.ny, *__restrict pnz = p.nz;
+    const float *__restrict par = p.ar, *__restrict pag = p.ag, *__restrict pab = p.ab, *__restrict pz = p.z;
+    const float *__restrict qr = q.r, *__restrict qg = q.g, *__restrict qb = q.b;
+    const float *__restrict qnx = q.nx, *__restrict qny = q.ny, *__restrict qnz = q.nz;
+    const float *__restrict qar = q.ar, *__restrict qag = q.ag, *__restrict qab = q.ab, *__restrict qz = q.z;
+    const float h = k.h, invC = k.invC, invN = k.invN, invA = k.invA, depthScale = k.depthScale;
+    for (int x = 0; x < count; ++x) {
+      const int j = QStride * x;
+      float dr = pr[x] - qr[j], dg = pg[x] - qg[j], db = pb[x] - qb[j];
+      float dc = (dr * dr + dg * dg + db * db) * invC;
+      float ex = pnx[x] - qnx[j], ey = pny[x] - qny[j], ez = pnz[x] - qnz[j];
+      float dn = (ex * ex + ey * ey + ez * ez) * invN;
+      float ax = par[x] - qar[j], ay = pag[x] - qag[j], az = pab[x] - qab[j];
+      float da = (ax * ax + ay * ay + az * az) * invA;
+      float zz = (pz[x] - qz[j]) / (depthScale * pz[x] + 1e-4f);
+      float w = h * expNeg(dc + dn + da + zz * zz);
+      sr[x] += w * qr[j]; sg[x] += w * qg[j]; sb[x] += w * qb[j]; sw[x] += w;
+    }
+  }
+
+  void filterRows(const Planes& in, Planes& out, const Planes& nrm, const Planes& alb,
+                  const std::vector<float>& depth, int width, int height, int step,
+                  float invC, int y0, int y1) const {
+    static const float kernel[5] = {1.0f / 16, 1.0f / 4, 3.0f / 8, 1.0f / 4, 1.0f / 16};
+    TapWeights k;
+    k.invC = invC;
+    k.invN = 1.0f / (settings.sigmaNormal * settings.sigmaNormal);
+    k.invA = 1.0f / (settings.sigmaAlbedo * settings.sigmaAlbedo);
+    k.depthScale = settings.sigmaDepth * step;
+    const Texel image{in.c[0].data(), in.c[1].data(), in.c[2].data(), nrm.c[0].data(), nrm.c[1].data(),
+                      nrm.c[2].data(), alb.c[0].data(), alb.c[1].data(), alb.c[2].data(), depth.data()};
+
+    std::vector<float> sr(width), sg(width), sb(width), sw(width);
+    for (int y = y0; y < y1; ++y) {
+      std::fill(sr.begin(), sr.end(), 0.0f);
+      std::fill(sg.begin(), sg.end(), 0.0f);
+      std::fill(sb.begin(), sb.end(), 0.0f);
+      std::fill(sw.begin(), sw.end(), 0.0f);
+      const size_t row = (size_t)y * width;
+
+      for (int ky = -2; ky <= 2; ++ky) {
+        // bordes por clamp, igual que extender la imagen
+        int qy = std::clamp(y + ky * step, 0, height - 1);
+        const size_t qrow = (size_t)qy * width;
+        for (int kx = -2; kx <= 2; ++kx) {
+          k.h = kernel[ky + 2] * kernel[kx + 2];
+          const int off = kx * step;
+          // [0, xa) repite la columna 0, [xa, xb) es el interior, [xb, width) repite la ultima
+          const int xa = std::min(width, std::max(0, -off)), xb = std::max(xa, std::min(width, width - off));
+          float *r = sr.data(), *g = sg.data(), *b = sb.data(), *w = sw.data();
+          accumulate<0>(image.at(row), image.at(qrow), xa, k, r, g, b, w);
+          accumulate<1>(image.at(row + xa), image.at(qrow + xa + off), xb - xa, k, r + xa, g + xa, b + xa, w + xa);
+          accumulate<0>(image.at(row + xb), image.at(qrow + width - 1), width - xb, k, r + xb, g + xb, b + xb, w + xb);
+        }
+      }
+
+      float* orr = out.c[0].data(); float* og = out.c[1].data(); float* ob = out.c[2].data();
+      for (int x = 0; x < width; ++x) {
+        // el tap central siempre aporta peso h > 0
+        float inv = 1.0f / sw[x];
+        orr[row + x] = sr[x] * inv; og[row + x] = sg[x] * inv; ob[row + x] = sb[x] * inv;
+      }
+    }
+  }
+};
+
+}
@@ -1,110 +1,227 @@
 #pragma once
 
 #include <algorithm>
+#include <cstdint>
 
 #include "scene/Scene.h"
+#include "utils/Random.h"
 
 namespace rt {
 
+// primer impacto de un rayo de camara, para llenar buffers auxiliares
+struct PrimaryHit {
+  bool hit = false;
+  HitRecord rec;
+};
+
 class Integrator {
  public:
   // Traza un rayo con recursion limitada por maxDepth
-  Vec3 trace(const Scene& scene, const Ray& ray, int depth) const {
+  // si primary no es nulo se guarda ahi el primer impacto (sin costo extra)
+  // seed alimenta la ruleta rusa; conviene que sea distinta por pixel y muestra
+  Vec3 trace(const Scene& scene, const Ray& ray, int depth, PrimaryHit* primary = nullptr,
+             uint32_t seed = 0) const {
+    uint32_t rng = seed;
+    return traceRec(scene, ray, depth, Vec3{1,1,1}, rng, primary);
+  }
+
+  // Piezas de trace para re-iluminar sin volver a intersectar el rayo de camara
+  // (ver Relighter). Dado el primer impacto rec de ray, con la misma semilla
+  // reproducen exactamente lo que trace habria sumado.
+
+  // sombreado completo del impacto: trace(ray) == shadeHit(ray, rec) si rec es el primer impacto
+  Vec3 shadeHit(const Scene& scene, const Ray& ray, const HitRecord& rec, int depth, uint32_t seed = 0) const {
+    uint32_t rng = seed;
+    return shadeDispatch(scene, ray, rec, depth, Vec3{1,1,1}, rng);
+  }
+
+  // aporte directo de una luz (difuso + especular), cero si esta ocluida
+  Vec3 lightTerm(const Scene& scene, const Ray& ray, const HitRecord& rec, const PointLight& light) const {
+    const Material& mat = *rec.material;
+    Vec3 toLight = light.position - rec.point;
+    double distLight = toLight.length();
+    Vec3 sdir = toLight / distLight;
+
+    // rayo de sombra
+    Ray shadowRay(rec.point + rec.normal * 1e-4, sdir);
+    bool occluded = scene.isOccluded(shadowRay, 1e-4, distLight - 1e-4);
+    if (occluded) return Vec3{0, 0, 0};
+
+    double ndotl = std::max(0.0, dot(rec.normal, sdir));
+    // Atenuacion simple por distancia (suave)
+    double fatt = 1.0 / (1.0 + 0.12 * distLight * distLight);
+    Vec3 diffuse = mat.Kd * (light.color * (light.intensity * fatt * ndotl));
+
+    Vec3 vdir = normalize(-ray.direction);
+    Vec3 rdir = reflect(-sdir, rec.normal);
+    double rdotv = std::max(0.0, dot(rdir, vdir));
+    Vec3 specular = mat.Ks * (light.color * std::pow(rdotv, mat.shininess) * light.intensity * fatt);
+
+    return diffuse + specular;
+  }
+
+  // rama reflejada de un material Mirror en su primer impacto
+  Vec3 reflectionTerm(const Scene& scene, const Ray& ray, const HitRecord& rec, int depth, uint32_t seed = 0) const {
+    uint32_t rng = seed;
+    return traceReflection(scene, ray, rec, depth, Vec3{1,1,1}, rec.material->reflectivity, rng);
+  }
+
+  // ramas cuyo peso acumulado (throughput) queda por debajo de este valor no se
+  // trazan; 0 desactiva la poda
+  double minContribution{1e-3};
+  // en lugar de cortar, seguir con probabilidad peso/minContribution y
+  // compensar dividiendo por esa probabilidad (sin sesgo)
+  bool russianRoulette{false};
+
+ private:
+  static double maxComponent(const Vec3& v) { return std::max(v.x, std::max(v.y, v.z)); }
+
+  // decide si se traza una rama con peso acumulado w; scale queda en 1 o en 1/q
+  bool keepBranch(const Vec3& w, uint32_t& rng, double& scale) const {
+    scale = 1.0;
+    double m = maxComponent(w);
+    if (m >= minContribution) return true;
+    if (!russianRoulette || m <= 0.0) return false;
+    double q = m / minContribution;
+    rng = hash32(rng + 0x9e3779b9u);
+    if (toUnit(rng) >= q) return false;
+    scale = 1.0 / q;
+    return true;
+  }
+
+  Vec3 traceRec(const Scene& scene, const Ray& ray, int depth, const Vec3& throughput,
+                uint32_t& rng, PrimaryHit* primary) const {
     if (depth <= 0) return scene.background;
 
     HitRecord rec;
     if (!scene.hit(ray, 1e-4, 1e9, rec)) {
       return scene.background;
     }
+    if (primary) {
+      primary->hit = true;
+      primary->rec = rec;
+    }
 
-    // componente ambiente y emision propia del material
-    Vec3 color = rec.material->Ka + rec.material->emissive;
-
-    // iluminacion directa Phong con sombras duras
-    if (!rec.material->isRefractive()) {
-      for (const auto& light : scene.lights) {
-        Vec3 toLight = light.position - rec.point;
-        double distLight = toLight.length();
-        Vec3 sdir = toLight / distLight;
-
-        // rayo de sombra
-        Ray shadowRay(rec.point + rec.normal * 1e-4, sdir);
-        HitRecord tmp;
-        bool occluded = scene.isOccluded(shadowRay, 1e-4, distLight - 1e-4);
-        if (occluded) continue;
-
-        double ndotl = std::max(0.0, dot(rec.normal, sdir));
-        // Atenuacion simple por distancia (suave)
-        double fatt = 1.0 / (1.0 + 0.12 * distLight * distLight);
-        Vec3 diffuse = rec.material->Kd * (light.color * (light.intensity * fatt * ndotl));
-
-        Vec3 vdir = normalize(-ray.direction);
-        Vec3 rdir = reflect(-sdir, rec.normal);
-        double rdotv = std::max(0.0, dot(rdir, vdir));
-        Vec3 specular = rec.material->Ks * (light.color * std::pow(rdotv, rec.material->shininess) * light.intensity * fatt);
-
-        color += diffuse + specular;
-      }
+    return shadeDispatch(scene, ray, rec, depth, throughput, rng);
+  }
+
+  // un solo salto por impacto; dentro de cada kernel las ramas por material ya no existen
+  Vec3 shadeDispatch(const Scene& scene, const Ray& ray, const HitRecord& rec, int depth,
+                     const Vec3& throughput, uint32_t& rng) const {
+    switch (rec.material->kind()) {
+      case MaterialKind::Diffuse:
+        return shade<MaterialKind::Diffuse>(scene, ray, rec, depth, throughput, rng);
+      case MaterialKind::Mirror:
+        return shade<MaterialKind::Mirror>(scene, ray, rec, depth, throughput, rng);
+      case MaterialKind::Dielectric:
+        return shade<MaterialKind::Dielectric>(scene, ray, rec, depth, throughput, rng);
+      case MaterialKind::Transmissive:
+        return shade<MaterialKind::Transmissive>(scene, ray, rec, depth, throughput, rng);
     }
+    return scene.background;
+  }
+
+  // iluminacion directa Phong con sombras duras, sumada luz por luz sobre color
+  void addDirectLight(const Scene& scene, const Ray& ray, const HitRecord& rec, Vec3& color) const {
+    for (const auto& light : scene.lights) color += lightTerm(scene, ray, rec, light);
+  }
+
+  // rama reflejada con peso w (escalar) sobre el throughput actual
+  Vec3 traceReflection(const Scene& scene, const Ray& ray, const HitRecord& rec, int depth,
+                       const Vec3& throughput, double w, uint32_t& rng) const {
+    double scale;
+    if (!keepBranch(throughput * w, rng, scale)) return Vec3{0, 0, 0};
+    Vec3 reflected = reflect(ray.direction, rec.normal);
+    Vec3 c = traceRec(scene, Ray(rec.point + rec.normal * 1e-4, reflected), depth - 1,
+                      throughput * (w * scale), rng, nullptr);
+    return w * scale * c;
+  }
 
-    // reflexion y refraccion recursivas
-    if (rec.material->isReflective() || rec.material->isRefractive()) {
-      Vec3 reflColor{0,0,0};
-      Vec3 refrColor{0,0,0};
+  // Kernel de sombreado por familia de material. Las condiciones dependen solo de K,
+  // asi cada instancia queda sin saltos por tipo de material y el compilador puede
+  // inlinear la iluminacion directa o descartarla entera (vidrio).
+  template <MaterialKind K>
+  Vec3 shade(const Scene& scene, const Ray& ray, const HitRecord& rec, int depth,
+             const Vec3& throughput, uint32_t& rng) const {
+    constexpr bool refractive = K == MaterialKind::Dielectric || K == MaterialKind::Transmissive;
+    constexpr bool reflective = K == MaterialKind::Mirror || K == MaterialKind::Dielectric;
+    const Material& mat = *rec.material;
 
-      // REFLEXION
-      if (rec.material->isReflective()) {
-        Vec3 reflected = reflect(ray.direction, rec.normal);
-        reflColor = trace(scene, Ray(rec.point + rec.normal * 1e-4, reflected), depth - 1);
+    // componente ambiente y emision propia del material
+    Vec3 color = mat.Ka + mat.emissive;
+
+    if constexpr (!refractive) {
+      addDirectLight(scene, ray, rec, color);
+      // Material puramente reflectivo (metal); cada rama lleva el peso acumulado
+      // del camino para poder podarla cuando su aporte no se veria
+      if constexpr (reflective) {
+        color += traceReflection(scene, ray, rec, depth, throughput, mat.reflectivity, rng);
       }
+      return color;
+    } else {
+      return shadeRefractive(scene, ray, rec, depth, throughput, rng, reflective, color);
+    }
+  }
 
-      // REFRACCION
-      if (rec.material->isRefractive()) {
-        double refraction_ratio = rec.frontFace ? (1.0 / rec.material->ior) : rec.material->ior;
-        Vec3 unit_direction = normalize(ray.direction);
-        Vec3 refracted;
-        bool can_refract = refract(unit_direction, rec.normal, refraction_ratio, refracted);
-
-        if (can_refract) {
-          Vec3 origin = rec.point - rec.normal * 1e-4;
-          double distInside = 0.0;
-          if (rec.frontFace) {
-            HitRecord exitRec;
-            if (scene.hit(Ray(origin, refracted), 1e-4, 1e9, exitRec)) {
-              distInside = exitRec.t;
-            }
-          }
-          Vec3 att{
-            std::exp(-rec.material->absorption.x * distInside),
-            std::exp(-rec.material->absorption.y * distInside),
-            std::exp(-rec.material->absorption.z * distInside)
-          };
-          refrColor = trace(scene, Ray(origin, refracted), depth - 1);
-          refrColor = refrColor * att * rec.material->transmissionTint;
-        } else {
-          // Reflexion interna total
-          Vec3 reflected = reflect(unit_direction, rec.normal);
-          refrColor = trace(scene, Ray(rec.point + rec.normal * 1e-4, reflected), depth - 1);
-        }
-
-        // Mezcla fisicamente plausible por Fresnel (Schlick)
-        double cosTheta = std::fmin(-dot(unit_direction, rec.normal), 1.0);
-        double iorFrom = rec.frontFace ? 1.0 : rec.material->ior;
-        double iorTo   = rec.frontFace ? rec.material->ior : 1.0;
-        double kr = schlickFresnel(cosTheta, iorFrom, iorTo);
-
-        // Si no calculamos refleccion antes (por material), la tomamos como 0
-        color += kr * reflColor + (1.0 - kr) * refrColor;
-      } else {
-        // Material puramente reflectivo (metal)
-        color += rec.material->reflectivity * reflColor;
+  // vidrio y medios transmisivos: Fresnel, reflexion interna total y refraccion con
+  // absorcion; reflective es constante en los kernels especializados
+  Vec3 shadeRefractive(const Scene& scene, const Ray& ray, const HitRecord& rec, int depth,
+                       const Vec3& throughput, uint32_t& rng, bool reflective, Vec3 color) const {
+    const Material& mat = *rec.material;
+    Vec3 unit_direction = normalize(ray.direction);
+    double refraction_ratio = rec.frontFace ? (1.0 / mat.ior) : mat.ior;
+    Vec3 refracted;
+    bool can_refract = refract(unit_direction, rec.normal, refraction_ratio, refracted);
+
+    // Mezcla fisicamente plausible por Fresnel (Schlick)
+    double cosTheta = std::fmin(-dot(unit_direction, rec.normal), 1.0);
+    double iorFrom = rec.frontFace ? 1.0 : mat.ior;
+    double iorTo   = rec.frontFace ? mat.ior : 1.0;
+    double kr = schlickFresnel(cosTheta, iorFrom, iorTo);
+    // Si el material no es reflectivo la reflexion cuenta como 0
+    double wRefl = reflective ? kr : 0.0;
+
+    if (!can_refract) {
+      // Reflexion interna total: las dos ramas siguen el mismo rayo, se traza una sola vez
+      double wTir = wRefl + (1.0 - kr);
+      Vec3 w = throughput * wTir;
+      double scale;
+      if (keepBranch(w, rng, scale)) {
+        Vec3 reflected = reflect(unit_direction, rec.normal);
+        Vec3 c = traceRec(scene, Ray(rec.point + rec.normal * 1e-4, reflected), depth - 1, w * scale, rng, nullptr);
+        color += wTir * scale * c;
       }
+      return color;
     }
 
+    // REFLEXION
+    if (wRefl > 0.0) color += traceReflection(scene, ray, rec, depth, throughput, wRefl, rng);
+
+    // REFRACCION
+    Vec3 origin = rec.point - rec.normal * 1e-4;
+    Vec3 att{1.0, 1.0, 1.0};
+    const Vec3& absorption = mat.absorption;
+    // el rayo extra hasta la salida solo hace falta si el medio absorbe
+    if (rec.frontFace && (absorption.x > 0.0 || absorption.y > 0.0 || absorption.z > 0.0)) {
+      double distInside = 0.0;
+      HitRecord exitRec;
+      if (scene.hit(Ray(origin, refracted), 1e-4, 1e9, exitRec)) {
+        distInside = exitRec.t;
+      }
+      att = Vec3{
+        std::exp(-absorption.x * distInside),
+        std::exp(-absorption.y * distInside),
+        std::exp(-absorption.z * distInside)
+      };
+    }
+    Vec3 wRefr = att * mat.transmissionTint * (1.0 - kr);
+    double scale;
+    if (keepBranch(throughput * wRefr, rng, scale)) {
+      Vec3 c = traceRec(scene, Ray(origin, refracted), depth - 1, throughput * wRefr * scale, rng, nullptr);
+      color += c * wRefr * scale;
+    }
     return color;
   }
 };
 
 }
-
-
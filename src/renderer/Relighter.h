@@ -0,0 +1,175 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "core/Framebuffer.h"
+#include "core/Ray.h"
+#include "lights/PointLight.h"
+#include "renderer/Integrator.h"
+#include "renderer/Renderer.h"
+#include "scene/Scene.h"
+
+namespace rt {
+
+// Re-iluminacion incremental. capture() traza una vez los rayos de camara y guarda
+// el primer impacto de cada muestra (G-buffer: punto, normal, material, rayo).
+// Despues, con la geometria y la camara fijas, relight() vuelve a sombrear solo
+// lo que depende de las luces:
+// - Diffuse: ambiente + una sombra y un Phong por luz; el aporte de cada luz se
+//   guarda por muestra y solo se recalcula para las luces que cambiaron o se agregaron
+// - Mirror: igual que Diffuse mas la rama reflejada, que se vuelve a trazar
+// - Dielectric / Transmissive: se vuelve a sombrear el impacto completo
+// El resultado es el mismo que un render completo con las luces nuevas. Cada pixel
+// solo toca sus muestras y su parte de terms, asi los pixeles se reparten entre hilos.
+class Relighter {
+ public:
+  // toma tamanio, spp, profundidad, sampler, integrador y formato del renderer
+  explicit Relighter(const Renderer& settings) : r(settings) {}
+
+  // traza los rayos primarios y devuelve el frame con las luces actuales de la escena
+  template <typename CameraT>
+  Framebuffer capture(const Scene& scene, const CameraT& camera) {
+    const int spp = r.spp;
+    samples.assign((size_t)r.width * r.height * spp, GSample{});
+    parallelPixels((size_t)r.width * r.height, [&](size_t begin, size_t end) {
+      for (size_t idx = begin; idx < end; ++idx) {
+        const int i = (int)(idx % r.width);
+        const int j = r.height - 1 - (int)(idx / r.width);
+        for (int s = 0; s < spp; ++s) {
+          // mismas posiciones de muestra y semillas que Renderer::render
+          double su = 0.5, sv = 0.5;
+          if (spp > 1) r.sampler->sample2D(i, j, s, spp, su, sv);
+          double u = (i + su) / (double)r.width;
+          double v = (j + sv) / (double)r.height;
+          GSample& g = samples[idx * spp + s];
+          g.ray = camera.getRay(u, v);
+          g.seed = hashCombine(hashCombine((uint32_t)i, (uint32_t)j), (uint32_t)s);
+          g.hit = r.maxDepth > 0 && scene.hit(g.ray, 1e-4, 1e9, g.rec);
+        }
+      }
+    });
+    lights.clear();
+    terms.clear();
+    return relight(scene);
+  }
+
+  // vuelve a sombrear el G-buffer con scene.lights; la geometria debe ser la de capture()
+  Framebuffer relight(const Scene& scene) {
+    const size_t numLights = scene.lights.size();
+    const size_t oldLights = lights.size();
+    // luces que cambiaron desde el frame anterior, comparando por posicion en la lista
+    std::vector<char> dirty(numLights, 1);
+    for (size_t k = 0; k < numLights && k < oldLights; ++k) dirty[k] = !sameLight(lights[k], scene.lights[k]);
+    if (numLights != oldLights) {
+      // se agregaron o quitaron luces: los aportes de las que siguen iguales se conservan
+      std::vector<Vec3> resized(samples.size() * numLights, Vec3{0, 0, 0});
+      size_t keep = std::min(numLights, oldLights);
+      for (size_t n = 0; n < samples.size() && keep > 0; ++n) {
+        for (size_t k = 0; k < keep; ++k) resized[n * numLights + k] = terms[n * oldLights + k];
+      }
+      terms.swap(resized);
+    }
+    lights = scene.lights;
+    lightsUpdated = 0;
+    for (char d : dirty) lightsUpdated += d ? 1 : 0;
+
+    const Integrator& integrator = r.integrator;
+    const int spp = r.spp;
+    Framebuffer pixels(r.width, r.height, r.format);
+    std::atomic<size_t> retracedTotal{0};
+    parallelPixels(pixels.size(), [&](size_t begin, size_t end) {
+      size_t retracedHere = 0;
+      for (size_t idx = begin; idx < end; ++idx) {
+        Vec3 color{0,0,0};
+        for (int s = 0; s < spp; ++s) {
+          size_t n = idx * spp + s;
+          const GSample& g = samples[n];
+          if (!g.hit) {
+            color += scene.background;
+            continue;
+          }
+          const Material& mat = *g.rec.material;
+          MaterialKind kind = mat.kind();
+          if (kind == MaterialKind::Dielectric || kind == MaterialKind::Transmissive) {
+            color += integrator.shadeHit(scene, g.ray, g.rec, r.maxDepth, g.seed);
+            ++retracedHere;
+            continue;
+          }
+          // misma suma, en el mismo orden, que Integrator::shade para Diffuse y Mirror
+          Vec3 c = mat.Ka + mat.emissive;
+          if (numLights > 0) {
+            Vec3* t = &terms[n * numLights];
+            for (size_t k = 0; k < numLights; ++k) {
+              if (dirty[k]) t[k] = integrator.lightTerm(scene, g.ray, g.rec, scene.lights[k]);
+              c += t[k];
+            }
+          }
+          if (kind == MaterialKind::Mirror) {
+            c += integrator.reflectionTerm(scene, g.ray, g.rec, r.maxDepth, g.seed);
+            ++retracedHere;
+          }
+          color += c;
+        }
+        color /= (double)spp;
+        pixels.set(idx, color);
+      }
+      retracedTotal += retracedHere;
+    });
+    retraced = retracedTotal;
+    return pixels;
+  }
+
+  // memoria del G-buffer y del cache de aportes por luz
+  size_t bytes() const { return samples.capacity() * sizeof(GSample) + terms.capacity() * sizeof(Vec3); }
+
+  // hilos para capture y relight (0 = hardware_concurrency)
+  int threads{0};
+
+  // estadisticas del ultimo frame
+  size_t lightsUpdated{0}; // luces recalculadas
+  size_t retraced{0};      // muestras que volvieron a trazar rebotes
+
+ private:
+  struct GSample {
+    Ray ray;
+    HitRecord rec;
+    uint32_t seed{0};
+    bool hit{false};
+  };
+
+  static bool sameLight(const PointLight& a, const PointLight& b) {
+    return a.position.x == b.position.x && a.position.y == b.position.y && a.position.z == b.position.z &&
+           a.color.x == b.color.x && a.color.y == b.color.y && a.color.z == b.color.z &&
+           a.intensity == b.intensity;
+  }
+
+  // reparte [0, count) en bloques contiguos de pixeles, uno por hilo
+  template <typename Fn>
+  void parallelPixels(size_t count, Fn fn) const {
+    size_t nt = threads > 0 ? (size_t)threads : std::max(1u, std::thread::hardware_concurrency());
+    nt = std::max<size_t>(1, std::min(nt, count));
+    if (nt == 1) {
+      fn(0, count);
+      return;
+    }
+    std::vector<std::thread> pool;
+    size_t chunk = (count + nt - 1) / nt;
+    for (size_t t = 0; t < nt; ++t) {
+      size_t begin = t * chunk, end = std::min(count, begin + chunk);
+      if (begin >= end) break;
+      pool.emplace_back(fn, begin, end);
+    }
+    for (auto& th : pool) th.join();
+  }
+
+  Renderer r;
+  std::vector<GSample> samples;
+  std::vector<PointLight> lights; // luces del frame anterior
+  std::vector<Vec3> terms;        // aporte de cada luz por muestra (samples x luces)
+};
+
+}
@@ -0,0 +1,274 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "camera/Camera.h"
+#include "core/Framebuffer.h"
+#include "renderer/Renderer.h"
+#include "renderer/TileCache.h"
+#include "scene/Scene.h"
+
+namespace rt {
+
+struct RenderResult {
+  Framebuffer pixels;
+  AuxBuffers aux;         // solo si se pidio withAux
+  bool cancelled{false};  // si se cancelo, los tiles que faltaban quedan en negro
+  TileCacheStats cache;   // aciertos y fallos de la cache de tiles de este trabajo
+  // Vacio si todo salio bien. Si un tile lanzo una excepcion (render, E/S de la
+  // cache u onTile) tiene su mensaje y el trabajo se corta como si se cancelara.
+  std::string error;
+};
+
+struct RenderOptions {
+  RenderMode mode{RenderMode::Final};
+  bool withAux{false};
+  int tileSize{32};
+  int priority{0}; // mayor = antes
+  // Se llama desde un hilo de trabajo al terminar cada tile. La region del tile en
+  // pixels (y en aux) ya es definitiva; el resto de la imagen puede estar a medio escribir.
+  std::function<void(const Tile&, const Framebuffer&)> onTile;
+  // si no es nulo, cada tile se busca primero en esta cache en disco (ver TileCache)
+  std::shared_ptr<TileCache> cache;
+};
+
+namespace detail {
+// estado compartido entre el servicio y sus trabajos, asi un RenderJob sigue siendo
+// valido aunque el servicio ya no exista
+struct ServiceCore {
+  std::mutex mtx;
+  std::condition_variable cv;
+  bool stopping{false};
+};
+}
+
+// Trabajo enviado a un RenderService. Se puede esperar, cancelar y cambiar de
+// prioridad mientras corre; los cambios valen a partir del proximo tile.
+class RenderJob {
+ public:
+  RenderJob(std::shared_ptr<detail::ServiceCore> c, std::shared_ptr<const Scene> s, const Camera& cam,
+            const Renderer& r, RenderOptions o, uint64_t order)
+    : core(std::move(c)), scene(std::move(s)), camera(cam), settings(r), opts(std::move(o)), seq(order),
+      prio(opts.priority), future(promise.get_future().share()) {
+    result.pixels = Framebuffer(settings.width, settings.height, settings.format);
+    if (opts.withAux) settings.prepareAux(result.aux);
+    if (opts.cache) digest = TileCache::digest(*scene, settings, opts.mode, opts.withAux);
+    int ts = std::max(1, opts.tileSize);
+    for (int y = 0; y < settings.height; y += ts) {
+      for (int x = 0; x < settings.width; x += ts) {
+        tiles.push_back(Tile{x, y, std::min(x + ts, settings.width), std::min(y + ts, settings.height)});
+      }
+    }
+  }
+
+  // bloquea hasta que el trabajo termina o se cancela
+  const RenderResult& wait() const { return future.get(); }
+  std::shared_future<RenderResult> resultFuture() const { return future; }
+
+  bool finished() const { return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready; }
+
+  void cancel() {
+    std::lock_guard<std::mutex> lock(core->mtx);
+    cancelRequested = true;
+    core->cv.notify_all();
+  }
+
+  void setPriority(int p) {
+    std::lock_guard<std::mutex> lock(core->mtx);
+    prio = p;
+    core->cv.notify_all();
+  }
+
+  int priority() const {
+    std::lock_guard<std::mutex> lock(core->mtx);
+    return prio;
+  }
+
+  // fraccion de tiles terminados, en [0,1]
+  double progress() const { return tiles.empty() ? 1.0 : (double)tilesDone.load() / tiles.size(); }
+
+ private:
+  friend class RenderService;
+
+  // todo lo que sigue se lee y escribe con core->mtx tomado, salvo los contadores
+  // atomicos y lo que solo escribe el constructor
+  bool hasWork() const { return !cancelRequested && nextTile < tiles.size(); }
+  bool canFinish() const { return !completed && inFlight == 0 && (cancelRequested || nextTile == tiles.size()); }
+
+  void finish() {
+    completed = true;
+    result.cancelled = tilesDone.load() < tiles.size();
+    result.cache.hits = cacheHits.load();
+    result.cache.misses = cacheMisses.load();
+    result.cache.uncached = cacheUncached.load();
+    promise.set_value(std::move(result));
+  }
+
+  std::shared_ptr<detail::ServiceCore> core;
+  std::shared_ptr<const Scene> scene;
+  Camera camera;
+  Renderer settings;
+  RenderOptions opts;
+  uint64_t seq;
+  int prio;
+  std::vector<Tile> tiles;
+  size_t nextTile{0};
+  size_t inFlight{0};
+  std::atomic<size_t> tilesDone{0};
+  TileCache::SceneDigest digest;
+  std::atomic<size_t> cacheHits{0};
+  std::atomic<size_t> cacheMisses{0};
+  std::atomic<size_t> cacheUncached{0};
+  bool cancelRequested{false};
+  bool completed{false};
+  RenderResult result;
+  std::promise<RenderResult> promise;
+  std::shared_future<RenderResult> future;
+};
+
+// Render no bloqueante para embeber el trazador. submit() devuelve enseguida un
+// RenderJob; un grupo fijo de hilos toma tiles del trabajo de mayor prioridad
+// (FIFO entre iguales), asi varios trabajos comparten los nucleos y uno urgente
+// adelanta a los demas sin esperar a que terminen. No escribe en stdout.
+class RenderService {
+ public:
+  explicit RenderService(size_t numThreads = 0) : core(std::make_shared<detail::ServiceCore>()) {
+    if (numThreads == 0) numThreads = std::max(1u, std::thread::hardware_concurrency());
+    for (size_t k = 0; k < numThreads; ++k) workers.emplace_back([this] { workerLoop(); });
+  }
+
+  RenderService(const RenderService&) = delete;
+  RenderService& operator=(const RenderService&) = delete;
+
+  // cancela lo que quede pendiente y espera a los hilos
+  ~RenderService() {
+    {
+      std::lock_guard<std::mutex> lock(core->mtx);
+      core->stopping = true;
+      for (auto& job : active) job->cancelRequested = true;
+    }
+    core->cv.notify_all();
+    for (auto& t : workers) t.join();
+  }
+
+  // settings aporta resolucion, spp, profundidad, formato, sampler e integrador
+  std::shared_ptr<RenderJob> submit(std::shared_ptr<const Scene> scene, const Camera& camera,
+                                    const Renderer& settings, RenderOptions opts = {}) {
+    // el trabajo (con el digest de la escena si hay cache) se arma fuera del lock,
+    // asi un submit no frena a los hilos que estan tomando tiles
+    auto job = std::make_shared<RenderJob>(core, std::move(scene), camera, settings, std::move(opts), nextSeq++);
+    std::lock_guard<std::mutex> lock(core->mtx);
+    if (core->stopping) {
+      job->cancelRequested = true;
+      job->finish();
+      return job;
+    }
+    active.push_back(job);
+    core->cv.notify_all();
+    return job;
+  }
+
+  size_t threadCount() const { return workers.size(); }
+
+ private:
+  // con el lock tomado: cierra los trabajos sin tiles pendientes ni en curso
+  void reap() {
+    for (size_t k = 0; k < active.size();) {
+      if (active[k]->canFinish()) {
+        active[k]->finish();
+        active.erase(active.begin() + k);
+      } else {
+        ++k;
+      }
+    }
+  }
+
+  // con el lock tomado: trabajo con tiles libres de mayor prioridad
+  std::shared_ptr<RenderJob> pick() const {
+    std::shared_ptr<RenderJob> best;
+    for (const auto& job : active) {
+      if (!job->hasWork()) continue;
+      if (!best || job->prio > best->prio || (job->prio == best->prio && job->seq < best->seq)) best = job;
+    }
+    return best;
+  }
+
+  void workerLoop() {
+    for (;;) {
+      std::shared_ptr<RenderJob> job;
+      Tile tile;
+      {
+        std::unique_lock<std::mutex> lock(core->mtx);
+        for (;;) {
+          reap();
+          job = pick();
+          if (job) {
+            tile = job->tiles[job->nextTile++];
+            ++job->inFlight;
+            break;
+          }
+          if (core->stopping && active.empty()) return;
+          core->cv.wait(lock);
+        }
+      }
+
+      RenderJob& jr = *job;
+      // una excepcion de un tile no puede salir del hilo (std::terminate mataria al
+      // proceso que embebe el servicio): falla ese trabajo y el hilo sigue
+      std::string failure;
+      try {
+        runTile(jr, tile);
+      } catch (const std::exception& e) {
+        failure = e.what();
+      } catch (...) {
+        failure = "excepcion desconocida";
+      }
+
+      {
+        std::lock_guard<std::mutex> lock(core->mtx);
+        --jr.inFlight;
+        if (!failure.empty() && jr.result.error.empty()) {
+          jr.result.error = "tile " + std::to_string(tile.x0) + "," + std::to_string(tile.y0) + ": " + failure;
+          jr.cancelRequested = true;
+        }
+        reap();
+      }
+      core->cv.notify_all();
+    }
+  }
+
+  static void runTile(RenderJob& jr, const Tile& tile) {
+    AuxBuffers* aux = jr.opts.withAux ? &jr.result.aux : nullptr;
+    if (jr.opts.cache) {
+      TileCacheStats st;
+      jr.opts.cache->renderTile(jr.digest, *jr.scene, jr.camera, jr.settings, jr.opts.mode, tile,
+                                jr.result.pixels, aux, &st);
+      jr.cacheHits += st.hits;
+      jr.cacheMisses += st.misses;
+      jr.cacheUncached += st.uncached;
+    } else {
+      jr.settings.renderTile(*jr.scene, jr.camera, jr.opts.mode, tile, jr.result.pixels, aux);
+    }
+    ++jr.tilesDone;
+    if (jr.opts.onTile) jr.opts.onTile(tile, jr.result.pixels);
+  }
+
+  std::shared_ptr<detail::ServiceCore> core;
+  std::vector<std::shared_ptr<RenderJob>> active;
+  std::vector<std::thread> workers;
+  std::atomic<uint64_t> nextSeq{0};
+};
+
+}
@@ -1,66 +1,177 @@
 #pragma once
 
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <vector>
-#include <iostream>
 
 #include "core/Vec3.h"
 #include "core/Ray.h"
+#include "core/Framebuffer.h"
+#include "geometry/AABB.h"
 #include "scene/Scene.h"
 #include "renderer/Integrator.h"
-#include "utils/Random.h"
+#include "sampling/Sampler.h"
 
 namespace rt {
 
 enum class RenderMode { Final, Normals };
 
+// buffers del primer impacto (AOVs), llenados en la misma pasada que la imagen final
+// normal en [-1,1] (cero si no hay impacto), albedo = Kd, profundidad = t (cero si no hay impacto)
+// normal y albedo se promedian sobre todas las muestras del pixel, la profundidad solo sobre las que
+// impactan (una silueta no queda a media distancia) y materialId es el de la primera que impacta (0 = sin impacto)
+// normal y albedo usan el mismo formato de pixel que la imagen final
+struct AuxBuffers {
+  Framebuffer normal;
+  Framebuffer albedo;
+  std::vector<float> depth;
+  std::vector<uint32_t> materialId;
+};
+
+// lo que alcanzan los rayos primarios de un tile (ver TileCache)
+struct TileReach {
+  AABB box;            // origenes de los rayos y primeros impactos
+  bool missed{false};  // algun rayo no choco con nada
+  bool bounced{false}; // algun primer impacto no es Diffuse: sus rebotes van a cualquier lado
+
+  inline void add(const Ray& r, const PrimaryHit& first) {
+    box.expand(r.origin);
+    if (!first.hit) {
+      missed = true;
+      return;
+    }
+    box.expand(first.rec.point);
+    if (first.rec.material->kind() != MaterialKind::Diffuse) bounced = true;
+  }
+};
+
+// region rectangular de la imagen [x0,x1) x [y0,y1), en filas de imagen (0 = arriba)
+struct Tile {
+  int x0{0}, y0{0}, x1{0}, y1{0};
+  inline int pixelCount() const { return (x1 - x0) * (y1 - y0); }
+};
+
 class Renderer {
  public:
   Renderer(int w, int h, int spp, int maxDepth)
     : width(w), height(h), spp(spp), maxDepth(maxDepth) {}
 
+  // render completo y bloqueante, fila por fila; no escribe en stdout (ver onProgress)
   template <typename CameraT>
-  std::vector<Vec3> render(const Scene& scene, const CameraT& camera, RenderMode mode) {
-    std::vector<Vec3> pixels(width * height);
-    Random rng;
-    Integrator integrator;
+  Framebuffer render(const Scene& scene, const CameraT& camera, RenderMode mode, AuxBuffers* aux = nullptr) const {
+    Framebuffer pixels(width, height, format);
+    if (aux) prepareAux(*aux);
+    for (int y = 0; y < height; ++y) {
+      renderTile(scene, camera, mode, Tile{0, y, width, y + 1}, pixels, aux);
+      if (onProgress) onProgress((int)std::round(100.0 * (y + 1) / (double)height));
+    }
+    return pixels;
+  }
+
+  // dimensiona los AOVs para esta resolucion (antes de renderTile con aux)
+  void prepareAux(AuxBuffers& aux) const {
+    aux.normal = Framebuffer(width, height, format);
+    aux.albedo = Framebuffer(width, height, format);
+    aux.depth.assign(width * height, 0.0f);
+    aux.materialId.assign(width * height, 0u);
+  }
+
+  // Renderiza solo los pixeles del tile sobre pixels (y aux, ya dimensionados).
+  // Cada pixel depende solo de su posicion, asi tiles distintos pueden hacerse en
+  // cualquier orden o en paralelo y el resultado es el mismo que render().
+  // El modo, la presencia de AOVs y la de reach se resuelven una vez aca; cada
+  // combinacion instancia su propio bucle de pixeles sin esas comparaciones por muestra.
+  // Si reach no es nulo se le agregan los rayos primarios y sus primeros impactos.
+  template <typename CameraT>
+  void renderTile(const Scene& scene, const CameraT& camera, RenderMode mode, const Tile& tile,
+                  Framebuffer& pixels, AuxBuffers* aux, TileReach* reach = nullptr) const {
+    if (reach) renderTileAs<true>(scene, camera, mode, tile, pixels, aux, reach);
+    else renderTileAs<false>(scene, camera, mode, tile, pixels, aux, nullptr);
+  }
+
+  int width{800};
+  int height{600};
+  int spp{1};
+  int maxDepth{6};
+  // si esta definido, render() lo llama al terminar cada fila con el porcentaje hecho
+  std::function<void(int)> onProgress;
+  // formato del framebuffer (la suma de muestras de cada pixel se hace en double)
+  PixelFormat format{PixelFormat::RGB32F};
+  Integrator integrator;
+  std::shared_ptr<const Sampler> sampler = std::make_shared<RandomSampler>();
 
-    for (int j = height - 1; j >= 0; --j) {
-      for (int i = 0; i < width; ++i) {
+ private:
+  template <bool WithReach, typename CameraT>
+  void renderTileAs(const Scene& scene, const CameraT& camera, RenderMode mode, const Tile& tile,
+                    Framebuffer& pixels, AuxBuffers* aux, TileReach* reach) const {
+    constexpr RenderMode N = RenderMode::Normals;
+    constexpr RenderMode F = RenderMode::Final;
+    if (aux) {
+      if (mode == N) renderLoop<N, true, WithReach>(scene, camera, tile, pixels, aux, reach);
+      else renderLoop<F, true, WithReach>(scene, camera, tile, pixels, aux, reach);
+    } else {
+      if (mode == N) renderLoop<N, false, WithReach>(scene, camera, tile, pixels, nullptr, reach);
+      else renderLoop<F, false, WithReach>(scene, camera, tile, pixels, nullptr, reach);
+    }
+  }
+
+  template <RenderMode Mode, bool WithAux, bool WithReach, typename CameraT>
+  void renderLoop(const Scene& scene, const CameraT& camera, const Tile& tile, Framebuffer& pixels,
+                  AuxBuffers* aux, TileReach* reach) const {
+    constexpr bool wantFirst = WithAux || WithReach;
+    for (int y = tile.y0; y < tile.y1; ++y) {
+      const int j = height - 1 - y;
+      for (int i = tile.x0; i < tile.x1; ++i) {
         Vec3 color{0,0,0};
+        Vec3 nSum{0,0,0};
+        Vec3 aSum{0,0,0};
+        double dSum = 0.0;
+        uint32_t matId = 0;
+        int hits = 0;
         for (int s = 0; s < spp; ++s) {
-          double u = (i + (spp > 1 ? rng.uniform01() : 0.5)) / (double)width;
-          double v = (j + (spp > 1 ? rng.uniform01() : 0.5)) / (double)height;
+          // con 1 spp se muestrea el centro del pixel
+          double su = 0.5, sv = 0.5;
+          if (spp > 1) sampler->sample2D(i, j, s, spp, su, sv);
+          double u = (i + su) / (double)width;
+          double v = (j + sv) / (double)height;
           Ray r = camera.getRay(u, v);
-          if (mode == RenderMode::Normals) {
-            HitRecord rec;
-            if (scene.hit(r, 1e-4, 1e9, rec)) {
-              Vec3 n = rec.normal;
+          PrimaryHit first;
+          if constexpr (Mode == RenderMode::Normals) {
+            first.hit = scene.hit(r, 1e-4, 1e9, first.rec);
+            if (first.hit) {
+              Vec3 n = first.rec.normal;
               color += 0.5 * (n + Vec3{1,1,1});
-            } else {
-              color += Vec3{0,0,0};
             }
           } else {
-            color += integrator.trace(scene, r, maxDepth);
+            uint32_t seed = hashCombine(hashCombine((uint32_t)i, (uint32_t)j), (uint32_t)s);
+            color += integrator.trace(scene, r, maxDepth, wantFirst ? &first : nullptr, seed);
+          }
+          if constexpr (WithReach) reach->add(r, first);
+          if constexpr (WithAux) {
+            if (first.hit) {
+              nSum += first.rec.normal;
+              aSum += first.rec.material->Kd;
+              dSum += first.rec.t;
+              if (hits++ == 0) matId = first.rec.material->id();
+            }
           }
         }
         color /= (double)spp;
-        pixels[(height - 1 - j) * width + i] = color;
+        int idx = y * width + i;
+        pixels.set(idx, color);
+        if constexpr (WithAux) {
+          aux->normal.set(idx, nSum / (double)spp);
+          aux->albedo.set(idx, aSum / (double)spp);
+          // promedio de las muestras que impactaron: en una silueta el cielo no acerca
+          // la profundidad (0 si ninguna impacto)
+          aux->depth[idx] = hits ? (float)(dSum / hits) : 0.0f;
+          aux->materialId[idx] = matId;
+        }
       }
-      // progreso por fila
-      int filasHechas = height - j;
-      int percent = (int)std::round(100.0 * filasHechas / (double)height);
-      std::cout << "\rprogreso: " << percent << "%" << std::flush;
     }
-    std::cout << "\n";
-    return pixels;
   }
-
-  int width{800};
-  int height{600};
-  int spp{1};
-  int maxDepth{6};
 };
 
 }
-
-
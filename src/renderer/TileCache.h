@@ -0,0 +1,502 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+#include "core/Framebuffer.h"
+#include "geometry/AABB.h"
+#include "renderer/Renderer.h"
+#include "scene/Scene.h"
+#include "utils/ContentHash.h"
+
+namespace rt {
+
+struct TileCacheStats {
+  size_t hits{0};     // tiles leidos de disco
+  size_t misses{0};   // tiles renderizados y guardados
+  size_t uncached{0}; // tiles que llegan a un objeto sin hash: se renderizan siempre
+};
+
+// Cache en disco de tiles ya renderizados, direccionada por contenido.
+//
+// Cada tile se identifica primero por su vista: ajustes del render (resolucion, spp,
+// profundidad, formato, integrador, modo, AOVs), luces, fondo y los rayos primarios
+// exactos del tile (camara, sampler y posicion). Generar esos rayos es barato; no se
+// intersectan.
+//
+// Al renderizar un tile se anota hasta donde llegaron sus rayos primarios (TileReach):
+// una caja con los origenes, los primeros impactos y las luces. Si todos los impactos
+// son Diffuse, el pixel solo depende de los segmentos camara-impacto e impacto-luz,
+// que quedan adentro de la caja, asi que solo importan los objetos cuya caja la toca.
+// Si algun rayo cae en un espejo o un vidrio, o se va al cielo, el tile depende de
+// toda la escena.
+//
+// El tile se guarda con el hash de la vista mas el contenido de esos objetos, y un
+// indice por vista recuerda las ultimas cajas de alcance. Al volver a renderizar se
+// recalcula el hash de contenido de cada caja del indice (solo tests de cajas, sin
+// trazar) y si el archivo existe se reutiliza. Mover una esfera o cambiarle el
+// material invalida solo los tiles que la ven o que ven su sombra, y deshacer el
+// cambio vuelve a encontrar los tiles anteriores.
+//
+// La carpeta tiene un tope de bytes. Un acierto actualiza la fecha de modificacion
+// del tile y de su indice; al pasarse del tope se borran los archivos mas viejos
+// por esa fecha (LRU) hasta quedar en el 90%, asi no se poda en cada escritura.
+class TileCache {
+ public:
+  static constexpr uint64_t kDefaultMaxBytes = 1ull << 30;
+
+  explicit TileCache(std::string directory, uint64_t maxBytes = kDefaultMaxBytes)
+    : dir(std::move(directory)), limit(maxBytes) {
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    approxBytes = scan().second;
+  }
+
+  TileCache(const TileCache&) = delete;
+  TileCache& operator=(const TileCache&) = delete;
+
+  // lo que comparten todas las claves de un frame; se arma una vez por render
+  struct SceneDigest {
+    uint64_t settings{0};   // ajustes + luces + fondo
+    uint64_t everything{0}; // toda la geometria; 0 si algun objeto no tiene hash
+    struct Prim {
+      AABB box;
+      bool bounded{false};
+      uint64_t hash{0};
+    };
+    std::vector<Prim> prims;
+    std::vector<Vec3> lights;
+  };
+
+  static SceneDigest digest(const Scene& scene, const Renderer& settings, RenderMode mode, bool withAux) {
+    SceneDigest d;
+    ContentHash h;
+    h.addBits(kVersion);
+    h.addBits((uint64_t)settings.width);
+    h.addBits((uint64_t)settings.height);
+    h.addBits((uint64_t)settings.spp);
+    h.addBits((uint64_t)(int64_t)settings.maxDepth);
+    h.addBits((uint64_t)settings.format);
+    h.add(settings.integrator.minContribution);
+    h.addBits(settings.integrator.russianRoulette ? 1 : 0);
+    h.addBits((uint64_t)mode);
+    h.addBits(withAux ? 1 : 0);
+    h.add(scene.background);
+    h.addBits(scene.lights.size());
+    for (const auto& l : scene.lights) {
+      h.add(l.position);
+      h.add(l.color);
+      h.add(l.intensity);
+      d.lights.push_back(l.position);
+    }
+    d.settings = h.value();
+
+    ContentHash all;
+    bool known = true;
+    scene.geometry.forEachPrimitive([&](const AABB* box, uint64_t ph) {
+      SceneDigest::Prim p;
+      p.bounded = box != nullptr;
+      if (box) p.box = *box;
+      p.hash = ph;
+      d.prims.push_back(p);
+      known = known && ph != 0;
+      all.addBits(ph);
+    });
+    d.everything = known ? all.value() : 0;
+    return d;
+  }
+
+  // hash de la vista del tile: ajustes, posicion y rayos primarios
+  template <typename CameraT>
+  static uint64_t viewKey(const SceneDigest& d, const CameraT& camera, const Renderer& settings, const Tile& tile) {
+    ContentHash h;
+    h.addBits(d.settings);
+    h.addBits((uint64_t)tile.x0);
+    h.addBits((uint64_t)tile.y0);
+    h.addBits((uint64_t)tile.x1);
+    h.addBits((uint64_t)tile.y1);
+    for (int y = tile.y0; y < tile.y1; ++y) {
+      const int j = settings.height - 1 - y;
+      for (int i = tile.x0; i < tile.x1; ++i) {
+        for (int s = 0; s < settings.spp; ++s) {
+          // mismas posiciones de muestra que Renderer::renderTile
+          double su = 0.5, sv = 0.5;
+          if (settings.spp > 1) settings.sampler->sample2D(i, j, s, settings.spp, su, sv);
+          Ray r = camera.getRay((i + su) / (double)settings.width, (j + sv) / (double)settings.height);
+          h.add(r.origin);
+          h.add(r.direction);
+        }
+      }
+    }
+    return h.value();
+  }
+
+  // alcance guardado en el indice: toda la escena o una caja
+  struct Reach {
+    bool everywhere{true};
+    AABB box;
+  };
+
+  static Reach reachOf(const TileReach& tr, const SceneDigest& d) {
+    Reach r;
+    r.everywhere = tr.missed || tr.bounced;
+    if (r.everywhere) return r;
+    r.box = tr.box;
+    for (const Vec3& l : d.lights) r.box.expand(l);
+    // los rayos de sombra salen 1e-4 por encima del impacto
+    r.box = r.box.padded(1e-3);
+    return r;
+  }
+
+  // hash de la geometria que alcanza reach en la escena actual; 0 si incluye algo sin hash
+  static uint64_t contentKey(const SceneDigest& d, const Reach& r) {
+    ContentHash h;
+    if (r.everywhere) {
+      if (d.everything == 0) return 0;
+      h.addBits(1);
+      h.addBits(d.everything);
+      return h.value();
+    }
+    h.addBits(0);
+    h.add(r.box.min);
+    h.add(r.box.max);
+    for (const auto& p : d.prims) {
+      if (p.bounded && !p.box.overlaps(r.box)) continue;
+      if (p.hash == 0) return 0;
+      h.addBits(p.hash);
+    }
+    return h.value();
+  }
+
+  // Busca el tile en disco o lo renderiza y lo guarda. Devuelve true si vino de la cache.
+  template <typename CameraT>
+  bool renderTile(const SceneDigest& d, const Scene& scene, const CameraT& camera, const Renderer& settings,
+                  RenderMode mode, const Tile& tile, Framebuffer& pixels, AuxBuffers* aux,
+                  TileCacheStats* stats = nullptr) {
+    const uint64_t view = viewKey(d, camera, settings, tile);
+    std::vector<Reach> seen = readIndex(view);
+    for (const Reach& r : seen) {
+      uint64_t content = contentKey(d, r);
+      if (content != 0 && load(entryKey(view, content), tile, pixels, aux)) {
+        touch(pathFor(entryKey(view, content), "tile"));
+        touch(pathFor(view, "idx"));
+        ++hits;
+        if (stats) ++stats->hits;
+        return true;
+      }
+    }
+
+    TileReach tr;
+    settings.renderTile(scene, camera, mode, tile, pixels, aux, &tr);
+    Reach r = reachOf(tr, d);
+    uint64_t content = contentKey(d, r);
+    if (content == 0) {
+      ++uncached;
+      if (stats) ++stats->uncached;
+      return false;
+    }
+    store(entryKey(view, content), tile, pixels, aux);
+    // la caja nueva va primero; las anteriores quedan para deshacer cambios
+    if (seen.empty() || !sameReach(seen[0], r)) {
+      std::vector<Reach> index{r};
+      for (const Reach& old : seen) {
+        if (index.size() >= kIndexSize) break;
+        if (!sameReach(old, r)) index.push_back(old);
+      }
+      writeIndex(view, index);
+    }
+    ++misses;
+    if (stats) ++stats->misses;
+    return false;
+  }
+
+  // render completo y bloqueante por tiles, con la misma imagen que Renderer::render
+  template <typename CameraT>
+  Framebuffer render(const Scene& scene, const CameraT& camera, const Renderer& settings, RenderMode mode,
+                     AuxBuffers* aux = nullptr, int tileSize = 32, TileCacheStats* stats = nullptr) {
+    Framebuffer pixels(settings.width, settings.height, settings.format);
+    if (aux) settings.prepareAux(*aux);
+    SceneDigest d = digest(scene, settings, mode, aux != nullptr);
+    const int ts = std::max(1, tileSize);
+    for (int y = 0; y < settings.height; y += ts) {
+      for (int x = 0; x < settings.width; x += ts) {
+        Tile tile{x, y, std::min(x + ts, settings.width), std::min(y + ts, settings.height)};
+        renderTile(d, scene, camera, settings, mode, tile, pixels, aux, stats);
+      }
+      if (settings.onProgress) {
+        int done = std::min(y + ts, settings.height);
+        settings.onProgress((int)std::round(100.0 * done / (double)settings.height));
+      }
+    }
+    return pixels;
+  }
+
+  // acumulado desde que se creo la cache
+  TileCacheStats totals() const {
+    TileCacheStats s;
+    s.hits = hits.load();
+    s.misses = misses.load();
+    s.uncached = uncached.load();
+    return s;
+  }
+
+  const std::string& directory() const { return dir; }
+
+  // archivos borrados desde que se creo la cache para respetar el tope
+  size_t evictedFiles() const { return evicted.load(); }
+
+  // Borra los archivos usados hace mas tiempo hasta que la carpeta ocupe a lo sumo
+  // targetBytes. Otro proceso puede estar usando la misma carpeta: se mide de nuevo
+  // en disco y un archivo que ya no esta no es un error. Devuelve cuantos se borraron.
+  size_t prune(uint64_t targetBytes) {
+    std::lock_guard<std::mutex> lock(pruneMutex);
+    auto [files, total] = scan();
+    std::sort(files.begin(), files.end(), [](const FileEntry& a, const FileEntry& b) { return a.mtime < b.mtime; });
+    size_t removed = 0;
+    for (const FileEntry& f : files) {
+      if (total <= targetBytes) break;
+      std::error_code ec;
+      if (std::filesystem::remove(f.path, ec)) ++removed;
+      total -= std::min(total, f.bytes);
+    }
+    approxBytes = total;
+    evicted += removed;
+    return removed;
+  }
+
+ private:
+  static constexpr uint64_t kVersion = 3;  // subir cuando cambia lo que produce un tile
+  static constexpr size_t kIndexSize = 8; // cajas de alcance recordadas por vista
+  static constexpr char kMagic[8] = {'R', 'T', 'T', 'I', 'L', 'E', '0', '1'};
+
+  static uint64_t entryKey(uint64_t view, uint64_t content) {
+    ContentHash h;
+    h.addBits(view);
+    h.addBits(content);
+    return h.value();
+  }
+
+  static bool sameReach(const Reach& a, const Reach& b) {
+    if (a.everywhere || b.everywhere) return a.everywhere == b.everywhere;
+    return a.box.min.x == b.box.min.x && a.box.min.y == b.box.min.y && a.box.min.z == b.box.min.z &&
+           a.box.max.x == b.box.max.x && a.box.max.y == b.box.max.y && a.box.max.z == b.box.max.z;
+  }
+
+  struct FileEntry {
+    std::filesystem::path path;
+    std::filesystem::file_time_type mtime;
+    uint64_t bytes;
+  };
+
+  // archivos de la cache (tiles, indices y temporales) y su tamanio total
+  std::pair<std::vector<FileEntry>, uint64_t> scan() const {
+    std::vector<FileEntry> files;
+    uint64_t total = 0;
+    std::error_code ec;
+    for (std::filesystem::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+      std::error_code fec;
+      if (!it->is_regular_file(fec)) continue;
+      const std::string ext = it->path().extension().string();
+      if (ext != ".tile" && ext != ".idx" && ext != ".tmp") continue;
+      FileEntry f{it->path(), it->last_write_time(fec), it->file_size(fec)};
+      if (fec) continue;
+      total += f.bytes;
+      files.push_back(std::move(f));
+    }
+    return {std::move(files), total};
+  }
+
+  static void touch(const std::string& path) {
+    std::error_code ec;
+    std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), ec);
+  }
+
+  // cuenta lo escrito y poda si se paso del tope; un solo hilo poda a la vez
+  void account(size_t bytes) {
+    if ((approxBytes += bytes) <= limit) return;
+    std::unique_lock<std::mutex> lock(pruneMutex, std::try_to_lock);
+    if (!lock) return;
+    lock.unlock();
+    prune(limit / 10 * 9);
+  }
+
+  std::string pathFor(uint64_t key, const char* ext) const {
+    char name[32];
+    std::snprintf(name, sizeof name, "%016llx.%s", (unsigned long long)key, ext);
+    return (std::filesystem::path(dir) / name).string();
+  }
+
+  static bool readFile(const std::string& path, std::string& buf) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) return false;
+    std::streamoff size = in.tellg();
+    if (size < 0) return false;
+    buf.resize((size_t)size);
+    in.seekg(0);
+    return (bool)in.read(&buf[0], size);
+  }
+
+  // se escribe aparte y se renombra: otro proceso nunca ve un archivo a medias.
+  // El temporal lleva pid e hilo porque varios procesos pueden compartir la carpeta.
+  void writeFile(const std::string& path, const std::string& buf) {
+    std::string tmp = path + "." + std::to_string(getpid()) + "." +
+                      std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + ".tmp";
+    {
+      std::ofstream out(tmp, std::ios::binary);
+      if (!out.write(buf.data(), (std::streamsize)buf.size())) return;
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp, path, ec);
+    if (ec) std::filesystem::remove(tmp, ec);
+    else account(buf.size());
+  }
+
+  // indice de una vista: magic, clave y por caja un flag (toda la escena) y min/max
+  std::vector<Reach> readIndex(uint64_t view) const {
+    std::vector<Reach> out;
+    std::string buf;
+    if (!readFile(pathFor(view, "idx"), buf)) return out;
+    const size_t entry = sizeof(uint64_t) + 6 * sizeof(double);
+    const size_t head = sizeof kMagic + sizeof(uint64_t);
+    if (buf.size() < head || (buf.size() - head) % entry != 0) return out;
+    if (buf.compare(0, sizeof kMagic, kMagic, sizeof kMagic) != 0) return out;
+    size_t pos = sizeof kMagic;
+    if (take<uint64_t>(buf, pos) != view) return out;
+    while (pos < buf.size()) {
+      Reach r;
+      r.everywhere = take<uint64_t>(buf, pos) != 0;
+      r.box.min.x = take<double>(buf, pos); r.box.min.y = take<double>(buf, pos); r.box.min.z = take<double>(buf, pos);
+      r.box.max.x = take<double>(buf, pos); r.box.max.y = take<double>(buf, pos); r.box.max.z = take<double>(buf, pos);
+      out.push_back(r);
+    }
+    return out;
+  }
+
+  void writeIndex(uint64_t view, const std::vector<Reach>& index) {
+    std::string buf(kMagic, sizeof kMagic);
+    put(buf, view);
+    for (const Reach& r : index) {
+      put<uint64_t>(buf, r.everywhere ? 1 : 0);
+      put(buf, r.box.min.x); put(buf, r.box.min.y); put(buf, r.box.min.z);
+      put(buf, r.box.max.x); put(buf, r.box.max.y); put(buf, r.box.max.z);
+    }
+    writeFile(pathFor(view, "idx"), buf);
+  }
+
+  template <typename T>
+  static void put(std::string& buf, T v) {
+    buf.append(reinterpret_cast<const char*>(&v), sizeof v);
+  }
+
+  template <typename T>
+  static T take(const std::string& buf, size_t& pos) {
+    T v;
+    std::memcpy(&v, buf.data() + pos, sizeof v);
+    pos += sizeof v;
+    return v;
+  }
+
+  // los canales se guardan en la precision del framebuffer: leerlos y volver a
+  // escribirlos deja exactamente los mismos bits
+  static void putImage(std::string& buf, const Framebuffer& fb, const Tile& tile) {
+    for (int y = tile.y0; y < tile.y1; ++y) {
+      for (int i = tile.x0; i < tile.x1; ++i) {
+        Vec3 c = fb.get((size_t)y * fb.width + i);
+        if (fb.format == PixelFormat::RGB64F) {
+          put(buf, c.x); put(buf, c.y); put(buf, c.z);
+        } else {
+          put(buf, (float)c.x); put(buf, (float)c.y); put(buf, (float)c.z);
+        }
+      }
+    }
+  }
+
+  static void takeImage(const std::string& buf, size_t& pos, Framebuffer& fb, const Tile& tile) {
+    for (int y = tile.y0; y < tile.y1; ++y) {
+      for (int i = tile.x0; i < tile.x1; ++i) {
+        Vec3 c;
+        if (fb.format == PixelFormat::RGB64F) {
+          c.x = take<double>(buf, pos); c.y = take<double>(buf, pos); c.z = take<double>(buf, pos);
+        } else {
+          c.x = take<float>(buf, pos); c.y = take<float>(buf, pos); c.z = take<float>(buf, pos);
+        }
+        fb.set((size_t)y * fb.width + i, c);
+      }
+    }
+  }
+
+  static size_t payloadBytes(const Tile& tile, const Framebuffer& fb, const AuxBuffers* aux) {
+    size_t channel = fb.format == PixelFormat::RGB64F ? sizeof(double) : sizeof(float);
+    size_t perPixel = 3 * channel;
+    if (aux) perPixel += 6 * channel + sizeof(float) + sizeof(uint32_t);
+    return sizeof kMagic + sizeof(uint64_t) + (size_t)tile.pixelCount() * perPixel;
+  }
+
+  bool load(uint64_t key, const Tile& tile, Framebuffer& pixels, AuxBuffers* aux) const {
+    std::string buf;
+    if (!readFile(pathFor(key, "tile"), buf)) return false;
+    // un archivo truncado o de otra version cuenta como fallo y se reescribe
+    if (buf.size() != payloadBytes(tile, pixels, aux) || buf.compare(0, sizeof kMagic, kMagic, sizeof kMagic) != 0) {
+      return false;
+    }
+    size_t pos = sizeof kMagic;
+    if (take<uint64_t>(buf, pos) != key) return false;
+    takeImage(buf, pos, pixels, tile);
+    if (aux) {
+      takeImage(buf, pos, aux->normal, tile);
+      takeImage(buf, pos, aux->albedo, tile);
+      for (int y = tile.y0; y < tile.y1; ++y) {
+        for (int i = tile.x0; i < tile.x1; ++i) {
+          size_t idx = (size_t)y * pixels.width + i;
+          aux->depth[idx] = take<float>(buf, pos);
+          aux->materialId[idx] = take<uint32_t>(buf, pos);
+        }
+      }
+    }
+    return true;
+  }
+
+  void store(uint64_t key, const Tile& tile, const Framebuffer& pixels, const AuxBuffers* aux) {
+    std::string buf(kMagic, sizeof kMagic);
+    put(buf, key);
+    putImage(buf, pixels, tile);
+    if (aux) {
+      putImage(buf, aux->normal, tile);
+      putImage(buf, aux->albedo, tile);
+      for (int y = tile.y0; y < tile.y1; ++y) {
+        for (int i = tile.x0; i < tile.x1; ++i) {
+          size_t idx = (size_t)y * pixels.width + i;
+          put(buf, aux->depth[idx]);
+          put(buf, aux->materialId[idx]);
+        }
+      }
+    }
+    writeFile(pathFor(key, "tile"), buf);
+  }
+
+  std::string dir;
+  uint64_t limit;
+  std::atomic<uint64_t> approxBytes{0}; // estimado de lo que ocupa la carpeta
+  std::atomic<size_t> evicted{0};
+  std::mutex pruneMutex;
+  std::atomic<size_t> hits{0};
+  std::atomic<size_t> misses{0};
+  std::atomic<size_t> uncached{0};
+};
+
+}
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "utils/Random.h"
+
+namespace rt {
+
+// Generador de posiciones de muestra dentro de un pixel, en [0,1)^2
+// No tiene estado mutable: la muestra depende solo de (pixel, indice, semilla),
+// asi que un mismo sampler se puede compartir entre hilos
+class Sampler {
+ public:
+  virtual ~Sampler() = default;
+  // index en [0, count), count = spp del render
+  virtual void sample2D(int px, int py, int index, int count, double& u, double& v) const = 0;
+
+  uint32_t seed{0};
+
+ protected:
+  inline uint32_t pixelHash(int px, int py) const {
+    return hashCombine(hashCombine((uint32_t)px, (uint32_t)py), seed);
+  }
+};
+
+// uniforme independiente (el jitter original)
+class RandomSampler : public Sampler {
+ public:
+  void sample2D(int px, int py, int index, int, double& u, double& v) const override {
+    uint32_t h = hashCombine(pixelHash(px, py), (uint32_t)index);
+    u = toUnit(h);
+    v = toUnit(hash32(h));
+  }
+};
+
+// jitter estratificado en grilla nx*ny; si spp no es cuadrado perfecto
+// las celdas usadas se eligen con una permutacion por pixel (Kensler 2013)
+class StratifiedSampler : public Sampler {
+ public:
+  void sample2D(int px, int py, int index, int count, double& u, double& v) const override {
+    uint32_t p = pixelHash(px, py);
+    int nx = (int)std::ceil(std::sqrt((double)count));
+    int ny = (count + nx - 1) / nx;
+    uint32_t cell = permute((uint32_t)index, (uint32_t)(nx * ny), p);
+    uint32_t h = hashCombine(p, (uint32_t)index);
+    u = ((cell % nx) + toUnit(h)) / nx;
+    v = ((cell / nx) + toUnit(hash32(h))) / ny;
+  }
+
+ private:
+  static uint32_t permute(uint32_t i, uint32_t l, uint32_t p) {
+    uint32_t w = l - 1;
+    w |= w >> 1; w |= w >> 2; w |= w >> 4; w |= w >> 8; w |= w >> 16;
+    do {
+      i ^= p; i *= 0xe170893du; i ^= p >> 16;
+      i ^= (i & w) >> 4; i ^= p >> 8; i *= 0x0929eb3fu;
+      i ^= p >> 23; i ^= (i & w) >> 1; i *= 1u | p >> 27;
+      i *= 0x6935fa69u; i ^= (i & w) >> 11; i *= 0x74dcb303u;
+      i ^= (i & w) >> 2; i *= 0x9e501cc3u; i ^= (i & w) >> 2;
+      i *= 0xc860a3dfu; i &= w; i ^= i >> 5;
+    } while (i >= l);
+    return (i + p) % l;
+  }
+};
+
+// Halton bases 2 y 3 con scrambling aleatorio de digitos por pixel
+class HaltonSampler : public Sampler {
+ public:
+  void sample2D(int px, int py, int index, int, double& u, double& v) const override {
+    uint32_t p = pixelHash(px, py);
+    u = scrambledRadicalInverse((uint32_t)index, 2, p);
+    v = scrambledRadicalInverse((uint32_t)index, 3, hash32(p));
+  }
+
+ private:
+  // cada digito k se desplaza (mod base) por un valor derivado de la semilla;
+  // se recorren tambien los ceros de la cola para que el punto quede uniforme
+  static double scrambledRadicalInverse(uint32_t i, uint32_t base, uint32_t seed) {
+    const double invBase = 1.0 / base;
+    double weight = invBase;
+    double r = 0.0;
+    for (uint32_t k = 0; weight > 1e-10; ++k) {
+      uint32_t digit = i % base;
+      i /= base;
+      uint32_t shift = hashCombine(seed, k) % base;
+      r += ((digit + shift) % base) * weight;
+      weight *= invBase;
+    }
+    return std::fmin(r, 0x1.fffffffffffffp-1);
+  }
+};
+
+// Sobol (0,2) en 2D con scrambling de Owen basado en hash (Burley 2020)
+class SobolSampler : public Sampler {
+ public:
+  void sample2D(int px, int py, int index, int, double& u, double& v) const override {
+    uint32_t p = pixelHash(px, py);
+    uint32_t i = nestedUniformScramble((uint32_t)index, p);
+    uint32_t x = nestedUniformScramble(reverseBits(i), hashCombine(p, 1u));
+    uint32_t y = nestedUniformScramble(sobolDim2(i), hashCombine(p, 2u));
+    u = toUnit(x);
+    v = toUnit(y);
+  }
+
+ private:
+  static uint32_t reverseBits(uint32_t x) {
+    x = (x << 16) | (x >> 16);
+    x = ((x & 0x00ff00ffu) << 8) | ((x & 0xff00ff00u) >> 8);
+    x = ((x & 0x0f0f0f0fu) << 4) | ((x & 0xf0f0f0f0u) >> 4);
+    x = ((x & 0x33333333u) << 2) | ((x & 0xccccccccu) >> 2);
+    x = ((x & 0x55555555u) << 1) | ((x & 0xaaaaaaaau) >> 1);
+    return x;
+  }
+
+  // segunda dimension de Sobol (polinomio x+1)
+  static uint32_t sobolDim2(uint32_t i) {
+    uint32_t r = 0;
+    for (uint32_t v = 1u << 31; i; i >>= 1, v ^= v >> 1) {
+      if (i & 1u) r ^= v;
+    }
+    return r;
+  }
+
+  static uint32_t laineKarras(uint32_t x, uint32_t seed) {
+    x += seed;
+    x ^= x * 0x6c50b47cu;
+    x ^= x * 0xb82f1e52u;
+    x ^= x * 0xc7afe638u;
+    x ^= x * 0x8d22f6e6u;
+    return x;
+  }
+
+  static uint32_t nestedUniformScramble(uint32_t x, uint32_t seed) {
+    return reverseBits(laineKarras(reverseBits(x), seed));
+  }
+};
+
+// secuencia R2 (Roberts) desplazada por pixel con una mascara de ruido azul
+// (interleaved gradient noise): el error residual queda en altas frecuencias
+class BlueNoiseSampler : public Sampler {
+ public:
+  void sample2D(int px, int py, int index, int, double& u, double& v) const override {
+    const double a1 = 0.7548776662466927; // 1/g, g = numero plastico
+    const double a2 = 0.5698402909980532; // 1/g^2
+    double su = toUnit(hashCombine(seed, 1u));
+    double sv = toUnit(hashCombine(seed, 2u));
+    double ou = gradientNoise(px, py) + su;
+    double ov = gradientNoise(px + 113, py + 71) + sv;
+    u = frac(ou + a1 * (index + 1));
+    v = frac(ov + a2 * (index + 1));
+  }
+
+ private:
+  static double frac(double x) { return x - std::floor(x); }
+
+  static double gradientNoise(int x, int y) {
+    return frac(52.9829189 * frac(0.06711056 * x + 0.00583715 * y));
+  }
+};
+
+// devuelve nullptr si el nombre no es conocido
+inline std::shared_ptr<Sampler> makeSampler(const std::string& name) {
+  if (name == "random") return std::make_shared<RandomSampler>();
+  if (name == "stratified") return std::make_shared<StratifiedSampler>();
+  if (name == "halton") return std::make_shared<HaltonSampler>();
+  if (name == "sobol") return std::make_shared<SobolSampler>();
+  if (name == "bluenoise") return std::make_shared<BlueNoiseSampler>();
+  return nullptr;
+}
+
+}
@@ -0,0 +1,279 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "core/Vec3.h"
+#include "geometry/Sphere.h"
+#include "geometry/Triangle.h"
+#include "geometry/Plane.h"
+#include "geometry/Quad.h"
+#include "geometry/Box.h"
+#include "geometry/Instance.h"
+#include "core/Transform.h"
+#include "materials/Material.h"
+#include "lights/PointLight.h"
+#include "camera/Camera.h"
+#include "scene/Scene.h"
+
+// Escenas de prueba del parcial, compartidas por el ejecutable y los benchmarks
+namespace rt {
+
+// Escena base: plano y tres esferas (difusa, metal, dielectrico)
+inline void buildBaseScene(Scene& scene) {
+  // Materiales simples
+  auto sueloMat = std::make_shared<Lambertian>(Vec3{0.75, 0.75, 0.75});
+  auto difusa = std::make_shared<Lambertian>(Vec3{0.80, 0.25, 0.25});
+  auto metal = std::make_shared<Metal>(Vec3{0.90, 0.90, 0.90}, 0.02, 1.0);
+  auto vidrio = std::make_shared<Dielectric>(1.5);
+  // Panel emisivo para que se vea brillante a traves del vidrio
+  auto rojo = std::make_shared<Lambertian>(Vec3{0.5, 0.1, 0.1});
+  rojo->emissive = Vec3{0.75, 0.1, 0.1}; // emite luz roja
+  auto naranja = std::make_shared<Lambertian>(Vec3{0.5, 0.3, 0.1});
+  naranja->emissive = Vec3{0.85, 0.5, 0.1}; // emite luz naranja
+
+  // Planos: suelo y fondo
+  scene.addObject(std::make_shared<Plane>(Vec3{0,1,0}, 0.0, sueloMat));      // y=0
+  scene.addObject(std::make_shared<Plane>(Vec3{0,0,1}, 4.0, sueloMat));      // z=-4
+
+  // Esferas
+  scene.addObject(std::make_shared<Sphere>(Vec3{-0.9, 0.5, -2.4}, 0.5, difusa)); // lambertiana
+  scene.addObject(std::make_shared<Sphere>(Vec3{ 0.0, 0.5, -2.8}, 0.5, metal));  // espejo
+  scene.addObject(std::make_shared<Sphere>(Vec3{ 1.0, 0.5, -2.2}, 0.5, vidrio)); // dielectric
+
+  // Panel de dos colores detras de la esfera de vidrio para verificar refraccion
+  // La esfera de vidrio esta en (1.0, 0.5, -2.2) con radio 0.5
+  // Su parte trasera esta en z = -2.2 - 0.5 = -2.7
+  // El panel debe estar MAS ATRAS que -2.7, pero no muy lejos
+  double zPanel = -3.4;
+  // Panel mas grande y centrado en la esfera de vidrio
+  // Mitad rojo / mitad amarillo: xM es el punto medio entre xL y xR
+  // Lo desplazamos un poco hacia la derecha manteniendo el ancho
+  double dx = 0.30;
+  double xL = 0.2 + dx, xR = 1.8 + dx;
+  double xM = 0.5 * (xL + xR);
+  double yB = -0.2, yT = 1.5;
+  // rectangulo izquierdo (rojo)
+  scene.addObject(std::make_shared<Quad>(Vec3{xL, yB, zPanel}, Vec3{xM - xL, 0, 0}, Vec3{0, yT - yB, 0}, rojo));
+  // rectangulo derecho (naranja)
+  scene.addObject(std::make_shared<Quad>(Vec3{xM, yB, zPanel}, Vec3{xR - xM, 0, 0}, Vec3{0, yT - yB, 0}, naranja));
+
+  // Luces
+  scene.lights.push_back(PointLight{Vec3{0.0, 2.2, -2.2}, Vec3{1,1,1}, 0.9});
+  scene.lights.push_back(PointLight{Vec3{-1.6, 1.6, -3.2}, Vec3{1.0, 0.95, 0.9}, 0.4});
+
+  // Fondo mas oscuro para que la refraccion del panel sea mas visible
+  scene.background = Vec3{0.2, 0.2, 0.3};
+}
+
+// Camaras de la escena base: reutilizamos presets para coherencia
+inline Camera makeBaseCamera(const std::string& cameraView, int width, int height) {
+  Vec3 lookAt{0.0, 0.4, -2.6};
+  Vec3 lookFrom;
+  Vec3 vup;
+  auto toLower = [](std::string s){ for (auto& c : s) c = (char)tolower(c); return s; };
+  std::string view = toLower(cameraView);
+  double fovDeg = 50.0;
+  if (view == "frontal" || view == "front") {
+    lookFrom = Vec3{0.0, 1.0, 1.2};
+    vup = Vec3{0.0, 1.0, 0.0};
+  } else if (view == "superior" || view == "top") {
+    lookFrom = Vec3{0.0, 2.2, 0.6};
+    lookAt = Vec3{0.0, 0.25, -2.4};
+    vup = Vec3{0.0, 1.0, 0.0};
+    fovDeg = 70.0;
+  } else if (view == "lateral" || view == "side") {
+    lookFrom = Vec3{-1.8, 1.0, -2.6};
+    vup = Vec3{0.0, 1.0, 0.0};
+    fovDeg = 65.0;
+  } else {
+    lookFrom = Vec3{0.0, 1.0, 1.2};
+    vup = Vec3{0.0, 1.0, 0.0};
+  }
+  double aspect = (double)width / (double)height;
+  return Camera(lookFrom, lookAt, vup, fovDeg, aspect);
+}
+
+// Escena final: habitacion de madera con espejo
+inline void buildFinalScene(Scene& scene) {
+  // Materiales
+  auto madera = std::make_shared<Lambertian>(Vec3{0.55, 0.36, 0.22});
+  auto marco = std::make_shared<Lambertian>(Vec3{0.05, 0.05, 0.05});
+  auto espejo = std::make_shared<Metal>(Vec3{0.95, 0.95, 0.95}, 0.02, 1.0);
+  auto difRoja = std::make_shared<Lambertian>(Vec3{0.80, 0.25, 0.25});
+  auto metalBlanco = std::make_shared<Metal>(Vec3{0.85, 0.85, 0.85}, 0.05, 1.0);
+  auto vidrio = std::make_shared<Dielectric>(1.5);
+  auto gris = std::make_shared<Lambertian>(Vec3{0.6, 0.6, 0.6});
+  auto lampara = std::make_shared<Lambertian>(Vec3{0.95, 0.95, 0.9});
+  lampara->emissive = Vec3{0.9, 0.9, 0.85};
+  lampara->castsShadow = false;
+
+  // Planos de la habitacion
+  // y = 0 (suelo): n=(0,1,0), d=0
+  scene.addObject(std::make_shared<Plane>(Vec3{0,1,0}, 0.0, madera));
+  // y = 2.5 (techo): n=(0,-1,0), d=2.5
+  scene.addObject(std::make_shared<Plane>(Vec3{0,-1,0}, 2.5, madera));
+  // x = -2.0 (pared izq): n=(1,0,0), d=2.0
+  scene.addObject(std::make_shared<Plane>(Vec3{1,0,0}, 2.0, madera));
+  // x = +2.0 (pared der): n=(-1,0,0), d=2.0
+  scene.addObject(std::make_shared<Plane>(Vec3{-1,0,0}, 2.0, madera));
+  // z = -6.0 (pared fondo): n=(0,0,1), d=6.0
+  scene.addObject(std::make_shared<Plane>(Vec3{0,0,1}, 6.0, madera));
+
+  // espejo en pared de fondo
+  double zMirror = -5.9995;
+  double xL = -1.8, xR = 1.8, yB = 0.2, yT = 2.3;
+  scene.addObject(std::make_shared<Quad>(Vec3{xL, yB, zMirror}, Vec3{xR - xL, 0, 0}, Vec3{0, yT - yB, 0}, espejo));
+
+  // marcos del espejo
+  double zFrame = -5.9993;
+  // marco izquierdo: x in [-2.0, xL], y in [0.0, 2.5]
+  scene.addObject(std::make_shared<Quad>(Vec3{-2.0, 0.0, zFrame}, Vec3{xL + 2.0, 0, 0}, Vec3{0, 2.5, 0}, marco));
+  // marco derecho: x in [xR, 2.0]
+  scene.addObject(std::make_shared<Quad>(Vec3{xR, 0.0, zFrame}, Vec3{2.0 - xR, 0, 0}, Vec3{0, 2.5, 0}, marco));
+  // marco inferior: y in [0.0, yB], x in [xL, xR]
+  scene.addObject(std::make_shared<Quad>(Vec3{xL, 0.0, zFrame}, Vec3{xR - xL, 0, 0}, Vec3{0, yB, 0}, marco));
+  // marco superior: y in [yT, 2.5], x in [xL, xR]
+  scene.addObject(std::make_shared<Quad>(Vec3{xL, yT, zFrame}, Vec3{xR - xL, 0, 0}, Vec3{0, 2.5 - yT, 0}, marco));
+
+  // lampara de techo
+  double yLamp = 2.30;
+  double xl0 = -0.35, xr0 = 0.35, zf0 = -3.6, zn0 = -2.8;
+  scene.addObject(std::make_shared<Quad>(Vec3{xl0, yLamp, zf0}, Vec3{xr0 - xl0, 0, 0}, Vec3{0, 0, zn0 - zf0}, lampara));
+
+  // lampara lateral
+  double xLamp2 = -1.9993;
+  double yL2b = 1.1, yL2t = 1.7;
+  double zL2n = -2.6, zL2f = -3.2;
+  scene.addObject(std::make_shared<Quad>(Vec3{xLamp2, yL2b, zL2n}, Vec3{0, yL2t - yL2b, 0}, Vec3{0, 0, zL2f - zL2n}, lampara));
+
+  // esferas
+  scene.addObject(std::make_shared<Sphere>(Vec3{-0.8, 0.5, -2.2}, 0.5, difRoja));
+  // metal especular
+  metalBlanco->reflectivity = 1.0;
+  scene.addObject(std::make_shared<Sphere>(Vec3{1.1, 0.5, -2.8}, 0.5, metalBlanco));
+
+  // triangulos adicionales
+  // triangulo apoyado en el piso, rotado levemente para ver dos caras (una especie de tetraedro)
+  Vec3 tA{-0.35, 0.0, -1.42}; // base izquierda en el piso
+  Vec3 tB{ 0.35, 0.0, -1.55}; // base derecha en el piso
+  Vec3 tC{ 0.00, 0.58, -1.50}; // punta superior
+  scene.addObject(std::make_shared<Triangle>(tA, tB, tC, gris));
+  // segunda cara, base invertida para formar la punta
+  Vec3 tB2{-0.35, 0.0, -1.55};
+  Vec3 tA2{ 0.35, 0.0, -1.42};
+  scene.addObject(std::make_shared<Triangle>(tA2, tB2, tC, gris));
+
+  // luz puntual principal (techo)
+  scene.lights.push_back(PointLight{Vec3{0.0, 2.22, -3.2}, Vec3{1,1,1}, 0.9});
+  // segunda luz puntual, alineada con la lampara de pared
+  scene.lights.push_back(PointLight{Vec3{-1.90, 1.40, -2.90}, Vec3{1.0, 0.9, 0.8}, 0.4});
+
+  // fondo
+  scene.background = Vec3{0.7, 0.8, 1.0};
+}
+
+// camaras pinhole de la escena final (la escena no depende de la vista)
+inline Camera makeFinalCamera(const std::string& cameraView, int width, int height) {
+  Vec3 lookAt{0.0, 0.7, -3.2};
+  Vec3 lookFrom;
+  Vec3 vup;
+  // elegir preset de camara sin modificar la escena
+  auto toLower = [](std::string s){ for (auto& c : s) c = (char)tolower(c); return s; };
+  std::string view = toLower(cameraView);
+  double fovDeg = 45.0;
+  if (view == "frontal" || view == "front") {
+    lookFrom = Vec3{0.0, 1.0, 1.8};
+    vup = Vec3{0.0, 1.0, 0.0};
+  } else if (view == "superior" || view == "top") {
+    // vista superior con un poquito de inclinacion para ver bien todos los objetos
+    // para mantenernos abajo del techo seteo y < 2.5 y se abre mas el fov (75)
+    lookFrom = Vec3{0.0, 2.45, 1.0};
+    // inclinar mas hacia el piso bajando el punto de interes
+    lookAt = Vec3{0.0, 0.30, -2.4};
+    vup = Vec3{0.0, 1.0, 0.0};
+    fovDeg = 75.0;
+  } else if (view == "lateral" || view == "side") {
+    // vista lateral desde la izquierda mirando hacia el centro
+    // no podemos superar x=-2.0 (pared izquierda). Alejamos un poco y abrimos FOV.
+    lookFrom = Vec3{-1.95, 1.0, -3.2};
+    vup = Vec3{0.0, 1.0, 0.0};
+    fovDeg = 70.0;
+  } else {
+    // por defecto, frontal
+    lookFrom = Vec3{0.0, 1.0, 1.8};
+    vup = Vec3{0.0, 1.0, 0.0};
+  }
+  double aspect = (double)width / (double)height;
+  return Camera(lookFrom, lookAt, vup, fovDeg, aspect);
+}
+
+// Escena de instancias: una mesa (tapa + 4 patas) armada una sola vez y
+// repetida en una grilla con rotaciones y materiales distintos
+inline void buildInstancesScene(Scene& scene) {
+  auto piso = std::make_shared<Lambertian>(Vec3{0.7, 0.7, 0.7});
+  auto madera = std::make_shared<Lambertian>(Vec3{0.55, 0.36, 0.22});
+  auto roja = std::make_shared<Lambertian>(Vec3{0.80, 0.25, 0.25});
+  auto metal = std::make_shared<Metal>(Vec3{0.85, 0.85, 0.85}, 0.0, 0.8);
+
+  auto mesa = std::make_shared<GeometryGroup>();
+  mesa->add(std::make_shared<Box>(Vec3{-0.5, 0.45, -0.3}, Vec3{0.5, 0.5, 0.3}, madera));
+  for (double sx : {-1.0, 1.0}) {
+    for (double sz : {-1.0, 1.0}) {
+      Vec3 c{0.42 * sx, 0.0, 0.22 * sz};
+      mesa->add(std::make_shared<Box>(c - Vec3{0.04, 0.0, 0.04}, c + Vec3{0.04, 0.45, 0.04}, madera));
+    }
+  }
+  mesa->freeze();
+
+  scene.addObject(std::make_shared<Plane>(Vec3{0,1,0}, 0.0, piso));
+  const int nx = 6, nz = 5;
+  for (int i = 0; i < nx; ++i) {
+    for (int k = 0; k < nz; ++k) {
+      Vec3 pos{(i - (nx - 1) * 0.5) * 1.4, 0.0, -2.0 - k * 1.3};
+      double ang = 17.0 * i + 29.0 * k;
+      double esc = 0.8 + 0.1 * ((i + k) % 3);
+      Transform xf = Transform::translate(pos) * Transform::rotate(Vec3{0,1,0}, ang) * Transform::scale(esc);
+      std::shared_ptr<Material> mat;
+      if ((i + k) % 4 == 1) mat = roja;
+      else if ((i + k) % 4 == 3) mat = metal;
+      scene.addObject(std::make_shared<Instance>(mesa, xf, mat));
+    }
+  }
+
+  scene.lights.push_back(PointLight{Vec3{0.0, 4.0, -2.0}, Vec3{1,1,1}, 0.9});
+  scene.lights.push_back(PointLight{Vec3{-3.0, 2.5, -6.0}, Vec3{1.0, 0.9, 0.8}, 0.6});
+  scene.background = Vec3{0.7, 0.8, 1.0};
+}
+
+inline Camera makeInstancesCamera(const std::string& cameraView, int width, int height) {
+  Vec3 lookAt{0.0, 0.3, -4.6};
+  Vec3 lookFrom{0.0, 2.0, 1.5};
+  double fovDeg = 55.0;
+  auto toLower = [](std::string s){ for (auto& c : s) c = (char)tolower(c); return s; };
+  std::string view = toLower(cameraView);
+  if (view == "superior" || view == "top") {
+    lookFrom = Vec3{0.0, 7.0, -1.0};
+    fovDeg = 70.0;
+  } else if (view == "lateral" || view == "side") {
+    lookFrom = Vec3{-6.5, 1.5, -4.6};
+    fovDeg = 60.0;
+  }
+  double aspect = (double)width / (double)height;
+  return Camera(lookFrom, lookAt, Vec3{0.0, 1.0, 0.0}, fovDeg, aspect);
+}
+
+// seleccion por nombre: "base", "instancias" o cualquier otro valor para la escena final
+inline void buildScene(const std::string& name, Scene& scene) {
+  if (name == "base") buildBaseScene(scene);
+  else if (name == "instancias") buildInstancesScene(scene);
+  else buildFinalScene(scene);
+}
+
+inline Camera makeCamera(const std::string& sceneName, const std::string& view, int width, int height) {
+  if (sceneName == "base") return makeBaseCamera(view, width, height);
+  if (sceneName == "instancias") return makeInstancesCamera(view, width, height);
+  return makeFinalCamera(view, width, height);
+}
+
+}
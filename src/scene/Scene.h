@@ -4,45 +4,38 @@
 #include <memory>
 
 #include "geometry/Hittable.h"
+#include "geometry/PrimitiveArena.h"
 #include "lights/PointLight.h"
+#include "materials/Material.h"
 
 namespace rt {
 
 class Scene {
  public:
-  void addObject(const std::shared_ptr<Hittable>& obj) { objects.push_back(obj); }
+  void addObject(const std::shared_ptr<Hittable>& obj) { geometry.add(obj); }
   void addLight(const PointLight& l) { lights.push_back(l); }
 
+  // compila la geometria a arreglos contiguos (ver PrimitiveArena::freeze);
+  // despues de congelar la escena es de solo lectura
+  void freeze() {
+    geometry.freeze();
+    lights.shrink_to_fit();
+  }
+
+  bool frozen() const { return geometry.frozen(); }
+
   bool hit(const Ray& r, double tMin, double tMax, HitRecord& rec) const {
-    HitRecord temp;
-    bool hitAnything = false;
-    double closest = tMax;
-    for (const auto& obj : objects) {
-      if (obj->hit(r, tMin, closest, temp)) {
-        hitAnything = true;
-        closest = temp.t;
-        rec = temp;
-      }
-    }
-    return hitAnything;
+    return geometry.hit(r, tMin, tMax, rec);
   }
 
   // test de oclusion para rayos de sombra: ignora objetos que no proyectan sombra
   bool isOccluded(const Ray& r, double tMin, double tMax) const {
-    HitRecord temp;
-    for (const auto& obj : objects) {
-      if (obj->hit(r, tMin, tMax, temp)) {
-        if (temp.material && temp.material->castsShadow) return true;
-      }
-    }
-    return false;
+    return geometry.isOccluded(r, tMin, tMax);
   }
 
-  std::vector<std::shared_ptr<Hittable>> objects;
+  PrimitiveArena geometry;
   std::vector<PointLight> lights;
   Vec3 background{0.7, 0.8, 1.0}; // cielo
 };
 
 }
-
-
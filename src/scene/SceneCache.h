@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <exception>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include "scene/Presets.h"
+#include "scene/Scene.h"
+
+namespace rt {
+
+// Escenas ya construidas y congeladas, por nombre, con politica LRU.
+// Pensado para el modo servidor: los trabajos seguidos sobre la misma escena
+// no vuelven a pagar la construccion ni el primer acceso a la memoria.
+// Las escenas se devuelven como shared_ptr, asi una escena desalojada sigue
+// viva mientras algun trabajo la este usando.
+// La construccion se hace fuera del lock: la entrada nueva guarda un
+// shared_future, y los pedidos simultaneos de la misma escena esperan ese
+// resultado en vez de construirla de nuevo, sin frenar a los de otras escenas.
+class SceneCache {
+ public:
+  explicit SceneCache(size_t capacity = 4) : capacity(capacity < 1 ? 1 : capacity) {}
+
+  // cached indica si la escena ya estaba construida
+  std::shared_ptr<const Scene> get(const std::string& name, bool* cached = nullptr) {
+    std::string key = canonical(name);
+    std::promise<SceneRef> built;
+    {
+      std::unique_lock<std::mutex> lock(mtx);
+      for (auto it = entries.begin(); it != entries.end(); ++it) {
+        if (it->first == key) {
+          entries.splice(entries.begin(), entries, it);
+          ++hits;
+          std::shared_future<SceneRef> pending = entries.front().second;
+          lock.unlock();
+          if (cached) *cached = true;
+          // si otro pedido la esta construyendo, espera ese resultado
+          return pending.get();
+        }
+      }
+      ++misses;
+      entries.emplace_front(key, built.get_future().share());
+      if (entries.size() > capacity) entries.pop_back();
+    }
+    if (cached) *cached = false;
+    try {
+      auto scene = std::make_shared<Scene>();
+      buildScene(key, *scene);
+      scene->freeze();
+      built.set_value(scene);
+      return scene;
+    } catch (...) {
+      // los que esperaban reciben el mismo error; el proximo pedido reintenta
+      built.set_exception(std::current_exception());
+      std::lock_guard<std::mutex> lock(mtx);
+      for (auto it = entries.begin(); it != entries.end(); ++it) {
+        if (it->first == key) {
+          entries.erase(it);
+          break;
+        }
+      }
+      throw;
+    }
+  }
+
+  size_t size() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return entries.size();
+  }
+
+  size_t hitCount() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return hits;
+  }
+
+  size_t missCount() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return misses;
+  }
+
+ private:
+  // mismo criterio que buildScene: cualquier nombre desconocido es la escena final
+  static std::string canonical(const std::string& name) {
+    if (name == "base" || name == "instancias") return name;
+    return "final";
+  }
+
+  using SceneRef = std::shared_ptr<const Scene>;
+
+  size_t capacity;
+  mutable std::mutex mtx;
+  std::list<std::pair<std::string, std::shared_future<SceneRef>>> entries;
+  size_t hits{0};
+  size_t misses{0};
+};
+
+}
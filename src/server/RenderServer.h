@@ -0,0 +1,317 @@
+#pragma once
+
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace rt {
+
+// Protocolo de linea sobre un socket Unix local:
+//   cliente -> servidor: una linea con los mismos argumentos que la linea de comandos
+//                        (separados por espacios), mas --priority N opcional;
+//                        o "estado" / "salir"
+//   servidor -> cliente: lineas de texto a medida que avanza el trabajo
+//                        ("encolado ...", "progreso N", "listo: ruta", "error: ...")
+//                        y al final "fin ok" o "fin error"; despues se cierra la conexion
+namespace proto {
+
+inline bool sendLine(int fd, const std::string& line) {
+  std::string msg = line + "\n";
+  size_t sent = 0;
+  while (sent < msg.size()) {
+    // MSG_NOSIGNAL: si el cliente se fue no queremos SIGPIPE en el servidor
+    ssize_t n = ::send(fd, msg.data() + sent, msg.size() - sent, MSG_NOSIGNAL);
+    if (n <= 0) return false;
+    sent += (size_t)n;
+  }
+  return true;
+}
+
+// lee hasta '\n' (sin incluirlo); false si se cerro la conexion antes
+inline bool readLine(int fd, std::string& line, size_t maxLen = 1 << 16) {
+  line.clear();
+  char c;
+  while (line.size() < maxLen) {
+    ssize_t n = ::read(fd, &c, 1);
+    if (n <= 0) return !line.empty();
+    if (c == '\n') return true;
+    if (c != '\r') line.push_back(c);
+  }
+  return true;
+}
+
+inline bool fillAddress(const std::string& path, sockaddr_un& addr) {
+  std::memset(&addr, 0, sizeof addr);
+  addr.sun_family = AF_UNIX;
+  if (path.empty() || path.size() >= sizeof addr.sun_path) return false;
+  std::memcpy(addr.sun_path, path.c_str(), path.size());
+  return true;
+}
+
+inline std::vector<std::string> tokenize(const std::string& line) {
+  std::vector<std::string> out;
+  std::istringstream in(line);
+  std::string tok;
+  while (in >> tok) out.push_back(tok);
+  return out;
+}
+
+}
+
+// Servidor de render de larga vida. Acepta conexiones en el hilo que llama a run();
+// la linea de pedido se lee en un hilo por conexion (con timeout), asi un cliente que
+// conecta y no manda nada no frena a los demas. Cada pedido se encola por prioridad
+// (mayor primero, FIFO entre iguales) y lo ejecuta un hilo trabajador llamando al
+// handler, que manda su salida al cliente con reply.
+class RenderServer {
+ public:
+  using Reply = std::function<void(const std::string&)>;
+  // recibe los argumentos del pedido (sin --priority); devuelve si el trabajo salio bien
+  using Handler = std::function<bool(const std::vector<std::string>&, const Reply&)>;
+
+  RenderServer(std::string socketPath, Handler h, size_t numWorkers = 1)
+    : path(std::move(socketPath)), handler(std::move(h)), workerCount(std::max<size_t>(1, numWorkers)) {}
+
+  RenderServer(const RenderServer&) = delete;
+  RenderServer& operator=(const RenderServer&) = delete;
+
+  ~RenderServer() { stop(); }
+
+  // bloquea hasta recibir "salir"; los trabajos ya encolados se terminan antes de volver
+  bool run() {
+    sockaddr_un addr;
+    if (!proto::fillAddress(path, addr)) {
+      std::cerr << "error: ruta de socket invalida " << path << "\n";
+      return false;
+    }
+    listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0) {
+      std::cerr << "error: no se pudo crear el socket\n";
+      return false;
+    }
+    ::unlink(path.c_str());
+    if (::bind(listenFd, (sockaddr*)&addr, sizeof addr) != 0 || ::listen(listenFd, 64) != 0) {
+      std::cerr << "error: no se pudo escuchar en " << path << "\n";
+      ::close(listenFd);
+      listenFd = -1;
+      return false;
+    }
+    std::cout << "escuchando en " << path << " (" << workerCount << " trabajadores)\n" << std::flush;
+
+    for (size_t w = 0; w < workerCount; ++w) workers.emplace_back([this] { workerLoop(); });
+
+    while (!stopping) {
+      int fd = ::accept(listenFd, nullptr, nullptr);
+      if (fd < 0) {
+        if (stopping) break;
+        continue;
+      }
+      timeval tv{kReadTimeoutSeconds, 0};
+      ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof tv);
+      {
+        std::lock_guard<std::mutex> lock(mtx);
+        ++readers;
+      }
+      std::thread([this, fd] {
+        handleConnection(fd);
+        std::lock_guard<std::mutex> lock(mtx);
+        --readers;
+        cv.notify_all();
+      }).detach();
+    }
+    stop();
+    return true;
+  }
+
+  // deja de aceptar pedidos, termina la cola y espera a los trabajadores
+  void stop() {
+    {
+      std::unique_lock<std::mutex> lock(mtx);
+      stopping = true;
+      if (listenFd >= 0) {
+        ::shutdown(listenFd, SHUT_RDWR);
+        ::close(listenFd);
+        listenFd = -1;
+        ::unlink(path.c_str());
+      }
+      // los hilos de lectura terminan solos (a lo sumo al vencer el timeout)
+      cv.notify_all();
+      cv.wait(lock, [this] { return readers == 0; });
+    }
+    cv.notify_all();
+    for (auto& t : workers) {
+      if (t.joinable()) t.join();
+    }
+    workers.clear();
+  }
+
+ private:
+  struct Job {
+    int priority;
+    uint64_t seq;
+    std::vector<std::string> args;
+    int fd;
+  };
+
+  struct JobOrder {
+    bool operator()(const Job& a, const Job& b) const {
+      if (a.priority != b.priority) return a.priority < b.priority;
+      return a.seq > b.seq;
+    }
+  };
+
+  void handleConnection(int fd) {
+    std::string line;
+    if (!proto::readLine(fd, line)) {
+      ::close(fd);
+      return;
+    }
+    std::vector<std::string> args = proto::tokenize(line);
+    if (args.size() == 1 && args[0] == "salir") {
+      proto::sendLine(fd, "fin ok");
+      ::close(fd);
+      std::lock_guard<std::mutex> lock(mtx);
+      stopping = true;
+      // despierta al accept de run(), que cierra el socket al salir del bucle
+      if (listenFd >= 0) ::shutdown(listenFd, SHUT_RDWR);
+      cv.notify_all();
+      return;
+    }
+    if (args.size() == 1 && args[0] == "estado") {
+      // el texto se arma con el lock y se manda sin el: un cliente lento no frena la cola
+      std::string status;
+      {
+        std::lock_guard<std::mutex> lock(mtx);
+        status = "en cola " + std::to_string(jobs.size()) + ", en curso " + std::to_string(running) +
+                 ", terminados " + std::to_string(finished);
+      }
+      proto::sendLine(fd, status);
+      proto::sendLine(fd, "fin ok");
+      ::close(fd);
+      return;
+    }
+
+    Job job{0, 0, {}, fd};
+    for (size_t k = 0; k < args.size(); ++k) {
+      if (args[k] == "--priority" && k + 1 < args.size()) {
+        try {
+          job.priority = std::stoi(args[++k]);
+        } catch (const std::exception&) {
+          proto::sendLine(fd, "error: prioridad invalida " + args[k]);
+          proto::sendLine(fd, "fin error");
+          ::close(fd);
+          return;
+        }
+      } else {
+        job.args.push_back(args[k]);
+      }
+    }
+    size_t ahead;
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      if (stopping) {
+        proto::sendLine(fd, "error: el servidor se esta cerrando");
+        proto::sendLine(fd, "fin error");
+        ::close(fd);
+        return;
+      }
+      job.seq = nextSeq++;
+      ahead = jobs.size();
+      proto::sendLine(fd, "encolado " + std::to_string(job.seq) + " (prioridad " +
+                          std::to_string(job.priority) + ", " + std::to_string(ahead) + " en cola)");
+      jobs.push(std::move(job));
+    }
+    cv.notify_one();
+  }
+
+  void workerLoop() {
+    for (;;) {
+      Job job;
+      {
+        std::unique_lock<std::mutex> lock(mtx);
+        cv.wait(lock, [this] { return stopping || !jobs.empty(); });
+        if (jobs.empty()) return;
+        job = jobs.top();
+        jobs.pop();
+        ++running;
+      }
+      int fd = job.fd;
+      Reply reply = [fd](const std::string& msg) { proto::sendLine(fd, msg); };
+      bool ok = false;
+      try {
+        ok = handler(job.args, reply);
+      } catch (const std::exception& e) {
+        reply(std::string("error: ") + e.what());
+      }
+      reply(ok ? "fin ok" : "fin error");
+      ::close(fd);
+      std::lock_guard<std::mutex> lock(mtx);
+      --running;
+      ++finished;
+    }
+  }
+
+  static constexpr time_t kReadTimeoutSeconds = 10;  // para mandar la linea de pedido
+
+  std::string path;
+  Handler handler;
+  size_t workerCount;
+  int listenFd{-1};
+  std::vector<std::thread> workers;
+
+  std::mutex mtx;
+  std::condition_variable cv;
+  std::priority_queue<Job, std::vector<Job>, JobOrder> jobs;
+  uint64_t nextSeq{0};
+  size_t running{0};
+  size_t finished{0};
+  size_t readers{0};  // hilos leyendo una linea de pedido
+  std::atomic<bool> stopping{false};
+};
+
+// Cliente minimo: manda una linea de pedido y copia las respuestas a out hasta "fin ..."
+// Devuelve true si el servidor respondio "fin ok".
+inline bool runRenderClient(const std::string& socketPath, const std::string& request, std::ostream& out) {
+  sockaddr_un addr;
+  if (!proto::fillAddress(socketPath, addr)) {
+    std::cerr << "error: ruta de socket invalida " << socketPath << "\n";
+    return false;
+  }
+  int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0 || ::connect(fd, (sockaddr*)&addr, sizeof addr) != 0) {
+    std::cerr << "error: no hay servidor escuchando en " << socketPath << "\n";
+    if (fd >= 0) ::close(fd);
+    return false;
+  }
+  bool ok = false;
+  if (proto::sendLine(fd, request)) {
+    std::string line;
+    while (proto::readLine(fd, line)) {
+      if (line == "fin ok" || line == "fin error") {
+        ok = line == "fin ok";
+        break;
+      }
+      out << line << "\n" << std::flush;
+    }
+  }
+  ::close(fd);
+  return ok;
+}
+
+}
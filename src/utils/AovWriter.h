@@ -0,0 +1,84 @@
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "core/Framebuffer.h"
+#include "core/Vec3.h"
+#include "renderer/Renderer.h"
+#include "utils/ImageWriterAuto.h"
+#include "utils/ImageWriterPFM.h"
+#include "utils/Random.h"
+
+namespace rt {
+
+// Escribe cada AOV en su propio archivo junto a la salida principal:
+// img/final.png -> img/final.normal.png, img/final.depth.png, ...
+// con asFloat se escriben en PFM lineal (img/final.normal.pfm) sin cuantizar
+class AovWriter {
+ public:
+  static bool isKnown(const std::string& aov) {
+    return aov == "beauty" || aov == "normal" || aov == "depth" || aov == "albedo" || aov == "matid";
+  }
+
+  static std::string pathFor(const std::string& out, const std::string& aov, bool asFloat) {
+    size_t slash = out.find_last_of('/');
+    size_t dot = out.find_last_of('.');
+    bool hasExt = dot != std::string::npos && (slash == std::string::npos || dot > slash);
+    std::string stem = hasExt ? out.substr(0, dot) : out;
+    std::string ext = asFloat ? ".pfm" : (hasExt ? out.substr(dot) : ".ppm");
+    return stem + "." + aov + ext;
+  }
+
+  // beauty, albedo y normal (en PFM) se escriben directo desde su framebuffer;
+  // el resto se convierte a un framebuffer float temporal
+  static bool write(const std::string& out, const std::string& aov, const Framebuffer& beauty,
+                    const AuxBuffers& aux, bool asFloat, int bitDepth = 0) {
+    const int width = beauty.width, height = beauty.height;
+    const size_t n = beauty.size();
+    std::string path = pathFor(out, aov, asFloat);
+    auto emit = [&](const Framebuffer& fb, bool gamma) {
+      if (asFloat) return ImageWriterPFM::write(path, fb);
+      return ImageWriterAuto::write(path, fb, gamma, bitDepth);
+    };
+
+    if (aov == "beauty") return emit(beauty, true);
+    if (aov == "albedo") return emit(aux.albedo, true);
+    if (aov == "normal" && asFloat) return emit(aux.normal, false);
+
+    Framebuffer img(width, height, PixelFormat::RGB32F);
+    if (aov == "normal") {
+      for (size_t k = 0; k < n; ++k) {
+        Vec3 nn = aux.normal.get(k);
+        bool hit = nn.lengthSquared() > 0.0;
+        img.set(k, hit ? 0.5 * (nn + Vec3{1,1,1}) : Vec3{0,0,0});
+      }
+    } else if (aov == "depth") {
+      float maxDepth = 0.0f;
+      for (size_t k = 0; k < n; ++k) maxDepth = std::max(maxDepth, aux.depth[k]);
+      for (size_t k = 0; k < n; ++k) {
+        double d = aux.depth[k];
+        // en 8 bits: cerca = claro, sin impacto = negro
+        double g = (d > 0.0 && maxDepth > 0.0f) ? 1.0 - d / maxDepth : 0.0;
+        img.set(k, asFloat ? Vec3{d, d, d} : Vec3{g, g, g});
+      }
+    } else if (aov == "matid") {
+      for (size_t k = 0; k < n; ++k) {
+        uint32_t id = aux.materialId[k];
+        if (asFloat) {
+          img.set(k, Vec3{(double)id, (double)id, (double)id});
+        } else if (id != 0) {
+          // color falso estable por id
+          uint32_t h = hash32(id);
+          img.set(k, Vec3{(h & 0xff) / 255.0, ((h >> 8) & 0xff) / 255.0, ((h >> 16) & 0xff) / 255.0});
+        }
+      }
+    } else {
+      return false;
+    }
+    return emit(img, false);
+  }
+};
+
+}
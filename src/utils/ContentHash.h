@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#include "core/Vec3.h"
+
+namespace rt {
+
+// Hash de contenido de 64 bits sobre los bits exactos de cada valor: cada palabra
+// se mezcla con el estado y pasa por el finalizador de MurmurHash3. Sirve para
+// claves de caches en disco: dos entradas con el mismo hash se consideran iguales,
+// por eso se hashean los doubles bit a bit y no redondeados.
+struct ContentHash {
+  uint64_t h{0x9e3779b97f4a7c15ull};
+
+  inline void addBits(uint64_t v) {
+    uint64_t x = h ^ v;
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ull;
+    x ^= x >> 33;
+    h = x;
+  }
+
+  inline void add(double d) {
+    uint64_t bits;
+    std::memcpy(&bits, &d, sizeof bits);
+    addBits(bits);
+  }
+
+  inline void add(const Vec3& v) {
+    add(v.x);
+    add(v.y);
+    add(v.z);
+  }
+
+  // 0 queda reservado para "contenido desconocido"
+  inline uint64_t value() const { return h ? h : 1u; }
+};
+
+}
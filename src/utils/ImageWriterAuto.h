@@ -1,27 +1,27 @@
 #pragma once
 
-#include <string>
-#include <vector>
+#include <cstdio>
 #include <cstdlib>
 #include <sstream>
-#include <unistd.h>
+#include <string>
 
-#include "core/Vec3.h"
+#include "core/Framebuffer.h"
 #include "utils/ImageWriterPPM.h"
 
 namespace rt {
 
 class ImageWriterAuto {
  public:
-  static bool write(const std::string& path, int width, int height, const std::vector<Vec3>& pixels, bool applyGamma=true) {
+  // bitDepth 0: PPM ASCII de 8 bits (ver ImageWriterPPM); el PNG sale de 8 bits
+  static bool write(const std::string& path, const Framebuffer& fb, bool applyGamma = true, int bitDepth = 0) {
     if (hasExtension(path, ".ppm")) {
-      return ImageWriterPPM::write(path, width, height, pixels, applyGamma);
+      return ImageWriterPPM::write(path, fb, applyGamma, bitDepth);
     }
     if (hasExtension(path, ".png")) {
-      return writePNG(path, width, height, pixels, applyGamma);
+      return writePNG(path, fb, applyGamma, bitDepth);
     }
     // por defecto, usa PPM
-    return ImageWriterPPM::write(path + ".ppm", width, height, pixels, applyGamma);
+    return ImageWriterPPM::write(path + ".ppm", fb, applyGamma, bitDepth);
   }
 
  private:
@@ -41,32 +41,21 @@ class ImageWriterAuto {
     return rc == 0;
   }
 
-  static bool writePNG(const std::string& path, int width, int height, const std::vector<Vec3>& pixels, bool applyGamma) {
-    // escribir ppm temporal y convertir con pnmtopng o convert si existen
-    std::ostringstream tmp;
-    tmp << "/tmp/rt_tmp_" << getpid() << ".ppm";
-    std::string tmpPath = tmp.str();
-    if (!ImageWriterPPM::write(tmpPath, width, height, pixels, applyGamma)) return false;
-
-    bool ok = false;
+  static bool writePNG(const std::string& path, const Framebuffer& fb, bool applyGamma, int bitDepth) {
+    // el PPM binario va por un pipe a pnmtopng o convert, sin archivo temporal
+    std::ostringstream cmd;
     if (commandExists("pnmtopng")) {
-      std::ostringstream cmd;
-      cmd << "pnmtopng \"" << tmpPath << "\" > \"" << path << "\"";
-      ok = (std::system(cmd.str().c_str()) == 0);
+      cmd << "pnmtopng > \"" << path << "\"";
     } else if (commandExists("convert")) {
-      std::ostringstream cmd;
-      cmd << "convert \"" << tmpPath << "\" \"" << path << "\"";
-      ok = (std::system(cmd.str().c_str()) == 0);
+      cmd << "convert ppm:- \"" << path << "\"";
+    } else {
+      return false;
     }
-
-    // limpiar temporal
-    std::ostringstream rm;
-    rm << "rm -f \"" << tmpPath << "\"";
-    std::system(rm.str().c_str());
-    return ok;
+    std::FILE* pipe = popen(cmd.str().c_str(), "w");
+    if (!pipe) return false;
+    bool ok = ImageWriterPPM::writeTo(pipe, fb, applyGamma, bitDepth ? bitDepth : 8);
+    return (pclose(pipe) == 0) && ok;
   }
 };
 
 }
-
-
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "core/Framebuffer.h"
+
+namespace rt {
+
+// Escritura en PFM (Portable Float Map, color "PF"): float32 little endian sin
+// clamp ni gamma, para AOVs lineales (profundidad, ids, normales)
+class ImageWriterPFM {
+ public:
+  static bool write(const std::string& path, const Framebuffer& fb) {
+    std::FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) return false;
+    // escala negativa = little endian
+    std::fprintf(f, "PF\n%d %d\n-1.0\n", fb.width, fb.height);
+    std::vector<float> row(3 * (size_t)fb.width);
+    bool ok = true;
+    // PFM guarda las filas de abajo hacia arriba
+    for (int j = fb.height - 1; j >= 0 && ok; --j) {
+      for (int i = 0; i < fb.width; ++i) {
+        Vec3 c = fb.at(i, j);
+        row[3 * i + 0] = (float)c.x;
+        row[3 * i + 1] = (float)c.y;
+        row[3 * i + 2] = (float)c.z;
+      }
+      ok = std::fwrite(row.data(), sizeof(float), row.size(), f) == row.size();
+    }
+    return (std::fclose(f) == 0) && ok;
+  }
+};
+
+}
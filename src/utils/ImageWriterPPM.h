@@ -1,41 +1,60 @@
 #pragma once
 
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
 #include <string>
 #include <vector>
-#include <fstream>
-#include <cmath>
 
+#include "core/Framebuffer.h"
 #include "core/Vec3.h"
 
 namespace rt {
 
-// Escritura de imagen en formato PPM (P3) para simplicidad
+// Escritura de imagen en formato PPM. Con bitDepth 0 es ASCII (P3) de 8 bits, el
+// formato de siempre; con 8 o 16 es binario (P6), mas compacto y rapido de leer.
+// Se cuantiza fila por fila directo desde el framebuffer.
 class ImageWriterPPM {
  public:
-  static bool write(const std::string& path, int width, int height, const std::vector<Vec3>& pixels, bool applyGamma=true) {
-    std::ofstream f(path);
-    if (!f.is_open()) return false;
-    f << "P3\n" << width << " " << height << "\n255\n";
-    for (int j = 0; j < height; ++j) {
-      for (int i = 0; i < width; ++i) {
-        const Vec3& c = pixels[j * width + i];
-        Vec3 out = clamp01(c);
+  static bool write(const std::string& path, const Framebuffer& fb, bool applyGamma = true, int bitDepth = 0) {
+    std::FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) return false;
+    bool ok = writeTo(f, fb, applyGamma, bitDepth);
+    return (std::fclose(f) == 0) && ok;
+  }
+
+  // tambien sirve para escribir a un pipe (ver ImageWriterAuto)
+  static bool writeTo(std::FILE* f, const Framebuffer& fb, bool applyGamma, int bitDepth) {
+    const bool ascii = bitDepth == 0;
+    const bool wide = bitDepth > 8;
+    const double maxVal = wide ? 65535.0 : 255.0;
+    std::fprintf(f, "%s\n%d %d\n%d\n", ascii ? "P3" : "P6", fb.width, fb.height, (int)maxVal);
+    std::vector<uint8_t> row((size_t)fb.width * 3 * (wide ? 2 : 1));
+    for (int j = 0; j < fb.height; ++j) {
+      size_t o = 0;
+      for (int i = 0; i < fb.width; ++i) {
+        Vec3 out = clamp01(fb.at(i, j));
         if (applyGamma) {
           // gamma aproximado 2.2
           out.x = std::pow(out.x, 1.0/2.2);
           out.y = std::pow(out.y, 1.0/2.2);
           out.z = std::pow(out.z, 1.0/2.2);
         }
-        int ir = static_cast<int>(255.999 * out.x);
-        int ig = static_cast<int>(255.999 * out.y);
-        int ib = static_cast<int>(255.999 * out.z);
-        f << ir << ' ' << ig << ' ' << ib << '\n';
+        if (ascii) {
+          std::fprintf(f, "%d %d %d\n", (int)(255.999 * out.x), (int)(255.999 * out.y), (int)(255.999 * out.z));
+          continue;
+        }
+        for (double c : {out.x, out.y, out.z}) {
+          unsigned v = static_cast<unsigned>((maxVal + 0.999) * c);
+          // P6 de 16 bits es big endian
+          if (wide) { row[o++] = (uint8_t)(v >> 8); row[o++] = (uint8_t)(v & 0xff); }
+          else row[o++] = (uint8_t)v;
+        }
       }
+      if (!ascii && std::fwrite(row.data(), 1, row.size(), f) != row.size()) return false;
     }
-    return true;
+    return !std::ferror(f);
   }
 };
 
 }
-
-
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <random>
 
 namespace rt {
@@ -15,6 +16,21 @@ class Random {
   std::uniform_real_distribution<double> dist01;
 };
 
+// hash entero sin estado (variante de PCG), util para numeros aleatorios
+// reproducibles por pixel/muestra sin compartir un generador entre hilos
+inline uint32_t hash32(uint32_t x) {
+  uint32_t state = x * 747796405u + 2891336453u;
+  uint32_t word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+  return (word >> 22u) ^ word;
 }
 
+inline uint32_t hashCombine(uint32_t a, uint32_t b) {
+  return hash32(a ^ (b + 0x9e3779b9u + (a << 6) + (a >> 2)));
+}
+
+// mapea 32 bits a [0,1)
+inline double toUnit(uint32_t x) {
+  return x * (1.0 / 4294967296.0);
+}
 
+}